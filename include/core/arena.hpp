@@ -8,6 +8,8 @@
 #include <core/game.hpp>
 #include <core/entity.hpp>
 #include <core/entity_type.hpp>
+#include <core/point.hpp>
+#include <ui/render_option.hpp>
 
 #define ARENA_WIDTH 102
 #define ARENA_HEIGHT 32
@@ -17,10 +19,60 @@ namespace core {
     //  Forward declarations
     class Game;
     class Entity;
+    class Air;
+    class Wall;
+    class ClusterGraph;
     struct Point;
 
+    //  A single cell of the arena grid.
+    //  Blocks (air and walls) are stored as plain values and are never allocated.
+    //  Any other entity lives in the arena's entity table, and the cell only keeps
+    //  the slot of that entity.
+    struct Cell {
+        //  The concrete type of what is in the cell. AIR or WALL for blocks.
+        //  Allows type checks on the grid without dereferencing the entity.
+        EntityType Type;
+        //  The slot of the entity in the entity table. -1 for blocks.
+        int Slot;
+    };
+
+    //  A copy of the type of every cell in the arena, taken under a single lock.
+    //  Used by systems that scan the whole grid (e.g. pathfinding) so that they
+    //  do not need to lock the arena once per cell.
+    struct OccupancySnapshot {
+        EntityType Types[ARENA_HEIGHT][ARENA_WIDTH];
+        //  The number of the change each row last changed in. A row whose version is unchanged
+        //  holds the same types as in an earlier snapshot of the same arena.
+        long long RowVersion[ARENA_HEIGHT];
+        //  Returns the type of the cell at (x, y).
+        EntityType At(Point p) const { return Types[p.y][p.x]; }
+    };
+
+    //  Everything the UI needs to draw one frame, copied at the end of a tick.
+    //  The renderer reads only from a published frame, so it never locks the arena and never
+    //  touches an entity the tick thread may be deleting.
+    struct FrameSnapshot {
+        //  The glyph and style of every cell.
+        ui::RenderOption Cells[ARENA_HEIGHT][ARENA_WIDTH];
+        //  Whether each cell holds a collectible.
+        bool Collectible[ARENA_HEIGHT][ARENA_WIDTH];
+        //  The number of the frame each row last changed in. A row whose version is unchanged
+        //  looks exactly as it did in the earlier frame, so the renderer can reuse what it drew.
+        long long RowVersion[ARENA_HEIGHT];
+        //  The state of the player and the game.
+        Point PlayerPosition;
+        int PlayerHp = 0;
+        int PlayerDamage = 0;
+        int Score = 0;
+        //  The game clock when the frame was taken.
+        long long Tick = 0;
+        //  The number of the frame. Only frames that changed are published, so a frame with the
+        //  same version as an earlier one is that same frame.
+        long long Version = 0;
+    };
+
     //  The arena. Every entity is placed inside.
-    //  The Entity[32][102] Arena->pixel  is the core object of our game.
+    //  The Cell[32][102] Arena->cells is the core object of our game.
     //  This is NOT the output frame. It's the internal structured data.
     class Arena {
         public:
@@ -28,10 +80,15 @@ namespace core {
             Arena();
             ~Arena();
 
-            //  Returns the width of the arena.
+            //  Returns the entity at (x, y).
+            //  Air and wall cells share one instance each per arena, so the position
+            //  of a returned block is meaningless.
             Entity* GetPixel(Point p);
             //  Sets the pixel at (x, y) to the given entity.
             void SetPixel(Point p, Entity* entity);
+            //  Sets the pixel at (x, y) to a block (AIR or WALL) without allocating.
+            //  The outermost layer is always wall and is left untouched.
+            void SetBlock(Point p, EntityType type);
             //  Sets the pixel safely at (x, y) to the given entity.
             //  This method will only set the pixel if the target pixel is air.
             bool SetPixelSafe(Point p, Entity* entity);
@@ -62,20 +119,59 @@ namespace core {
             std::vector<Entity*> GetMappedEntities();
             //  Returns a list of entities of the given type.
             std::list<Entity*> GetEntitiesOfType(EntityType type);
+            //  Copies the type of every cell into the given snapshot.
+            void TakeSnapshot(OccupancySnapshot& snapshot);
+            //  Copies the glyph and style of every cell into the given frame, under a single lock.
+            //  The rows that changed since the previous frame taken are marked with a new version.
+            //  Returns true if any row changed.
+            bool TakeFrame(FrameSnapshot& frame);
+            //  Builds the cluster graph of the walls, used by hierarchical pathfinding.
+            //  Walls never change once the map is loaded, so this is called once at load time.
+            void BuildClusterGraph();
+            //  Returns the cluster graph of the walls. nullptr if it has not been built.
+            const ClusterGraph* GetClusterGraph();
 
         private:
-            //  A pixel is one single entity in the arena.
-            //  Entity can be air, wall, player, mob, etc.
-            Entity* pixel[ARENA_HEIGHT][ARENA_WIDTH];
+            //  A cell is one single pixel in the arena.
+            //  Cells are either air, wall, or a slot in the entity table.
+            Cell cells[ARENA_HEIGHT][ARENA_WIDTH];
+            //  The non-block entities placed in the arena, indexed by slot.
+            //  Freed slots are set to nullptr and reused through freeSlots.
+            std::vector<Entity*> entityTable;
+            std::vector<int> freeSlots;
+            //  The shared instances returned by GetPixel() for block cells.
+            Air* air;
+            Wall* wall;
+            //  The cluster graph of the walls. Built by BuildClusterGraph().
+            ClusterGraph* clusterGraph = nullptr;
 
             //  Used for efficiently searching through non-block entities.
             //  The id is incremented for each non-block entity created.
             int idIncr = 0;
             Game* game;
+            //  The cells as of the last frame taken, and the version of each row. Used to find the
+            //  rows that changed, whether an entity moved or just changed its look (e.g. blinking).
+            ui::RenderOption frameCells[ARENA_HEIGHT][ARENA_WIDTH];
+            long long frameRowVersions[ARENA_HEIGHT] = {};
+            long long frameCount = 0;
+            //  The version of each row of cell types, and the number of changes made so far.
+            //  Copied into every OccupancySnapshot so its readers can skip the unchanged rows.
+            long long occupancyRowVersions[ARENA_HEIGHT] = {};
+            long long occupancyVersion = 0;
             //  Thread lock for the arena.
             std::mutex arenaMutex;
             //  Maps the ID to the entity.
             std::unordered_map<int, Entity*> entityIndex;
+
+            //  The helpers below assume arenaMutex is already held.
+
+            //  Returns the entity at (x, y).
+            Entity* entityAt(Point p);
+            //  Deletes the entity at (x, y), if any, and turns the cell into air. Marks the row changed.
+            void clearCell(Point p);
+            //  Places the entity at (x, y), deleting whatever was there before.
+            //  Blocks passed in are converted into plain cells and deleted.
+            void placeEntity(Point p, Entity* entity);
     };
 
 }
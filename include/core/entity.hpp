@@ -6,6 +6,7 @@
 #include <core/arena.hpp>
 #include <core/point.hpp>
 #include <core/entity_type.hpp>
+#include <core/timer_wheel.hpp>
 #include <ui/render_option.hpp>
 
 namespace core {
@@ -50,7 +51,8 @@ namespace core {
     class Entity {
         public:
             // Constructor
-            Entity(Point position, Arena* arena);
+            //  The type is the concrete type of the entity, i.e. the TypeId of the subclass.
+            Entity(Point position, Arena* arena, EntityType type);
             virtual ~Entity() = default;
 
             Point GetPosition();
@@ -59,12 +61,20 @@ namespace core {
             void SetPosition(Point position);
             virtual bool Move(Point to) = 0;
             //  Returns true if the entity is of the given type.
-            //  This is a wrapper for dynamic_cast.
-            static bool IsType(Entity* entity, EntityType type);
+            //  Abstract types match every type deriving from them. This is a single AND
+            //  against the entity's ancestry mask, so it is cheap enough for hot loops.
+            static bool IsType(Entity* entity, EntityType type) {
+                return entity != nullptr && (entity->typeMask & TypeBit(type)) != 0;
+            }
+            //  Returns the concrete type of the entity.
+            EntityType GetType() const;
             //  Returns the render option of the entity
             ui::RenderOption GetRenderOption();
             //  The ID of the entity. For unmapped entities, the ID will be negative.
             int Id = -1;
+            //  The tick the entity is scheduled to wake up at, TimerWheel::DUE or TimerWheel::IDLE.
+            //  Only managed by the TimerWheel of the game.
+            long long WakeupTick = TimerWheel::IDLE;
 
         protected:
 
@@ -77,6 +87,10 @@ namespace core {
         private:
             //  The position of the entity in the arena.
             Point position;
+            //  The concrete type of the entity.
+            EntityType type;
+            //  The ancestry mask of the concrete type. See TypeAncestry().
+            unsigned int typeMask;
     };
 
     //  -- Abstract Classes ---------------------------------------------------------
@@ -86,7 +100,7 @@ namespace core {
     class AbstractBlock : public Entity {
         public:
             //  Constructor
-            AbstractBlock(Point position, Arena* arena);
+            AbstractBlock(Point position, Arena* arena, EntityType type);
             virtual ~AbstractBlock() = default;
 
             bool Move(Point to) override;
@@ -97,7 +111,7 @@ namespace core {
     class AbstractMob : public Entity {
         public:
             //  Constructor
-            AbstractMob(Point position, Arena* arena, int hp, int damage, int killScore, int ticksPerMove);
+            AbstractMob(Point position, Arena* arena, EntityType type, int hp, int damage, int killScore, int ticksPerMove);
             virtual ~AbstractMob() = default;
 
             // Applies HP to the mob.
@@ -107,7 +121,8 @@ namespace core {
             //  Changes the damage value by delta.
             void ChangeDamage(int delta);
             //  Moves the mob to the given position.
-            //  Returns true if the mob was able to move.
+            //  Returns true if the mob was able to move. Moving to the mob's own position is a
+            //  planned wait: it uses up the move without going anywhere, and returns true.
             //  Only used internally in the AbstractMob class.
             //  Please call Move() that takes no arguments to move the mob along its path.
             bool Move(Point to) override;
@@ -116,10 +131,20 @@ namespace core {
             bool Move();
             //  The path towards the player. Updated through MobMoveEventHandler.
             std::list<Point> Path;
+            //  The cell Path was planned towards. Path may end short of it: hierarchical
+            //  pathfinding only refines the first hop of its route.
+            Point PathGoal = {-1, -1};
             //  Returns the kill score of the mob.
             int GetKillScore() const;
             //  Applies a shield to the mob for a given duration in ticks.
             void ApplyShield(int duration);
+            //  Returns the speed of the mob, in ticks per move.
+            int GetTicksPerMove() const;
+            //  Returns the earliest tick at which the mob may move again.
+            long long GetNextMoveTick() const;
+            //  Returns the tick the mob should be woken up at by the scheduler: its next move, or
+            //  the expiry of its shield if that comes first, so that the shield stops showing.
+            long long GetNextWakeupTick() const;
 
         private:
             int hp;
@@ -141,7 +166,7 @@ namespace core {
     class AbstractCollectible : public Entity {
         public:
             //  Constructor
-            AbstractCollectible(Point position, Arena* arena, int lifetime);
+            AbstractCollectible(Point position, Arena* arena, EntityType type, int lifetime);
             //  Let the given entity pick up the collectible.
             //  Returns true if the entity was able to pick up the collectible.
             virtual bool PickUp(Entity* by) = 0;
@@ -150,12 +175,17 @@ namespace core {
             void RefreshStatus();
             //  Determines if the collectible has expired/been picked up.
             bool IsInvalid() const;
+            //  Returns the tick the collectible should be woken up at by the scheduler: when it
+            //  starts blinking, then when it expires.
+            long long GetNextWakeupTick() const;
             //  The override of the Move() method. Always returns false.
             bool Move(Point p) override;
 
         protected:
             //  Whether the collectible has been picked up.
             bool pickedUp = false;
+            //  Marks the collectible as picked up, and wakes it up so that it is removed at once.
+            void markPickedUp();
 
         private:
             //  The tick when the collectible was spawned.
@@ -169,6 +199,8 @@ namespace core {
 
     class PlayerBullet : public Entity {
         public:
+            //  The compile-time type id of the class.
+            static constexpr EntityType TypeId = EntityType::PLAYER_BULLET;
             PlayerBullet(Point position, Arena* arena, int damage, int direction);
 
             //  The bullet moves in the given direction. Should only be used internally.
@@ -211,6 +243,8 @@ namespace core {
 
     class Wall : public AbstractBlock {
         public:
+            //  The compile-time type id of the class.
+            static constexpr EntityType TypeId = EntityType::WALL;
             //  Constructor
             //  The wall is a block that cannot be moved through.
             //  It is used to create the walls of the arena.
@@ -219,6 +253,8 @@ namespace core {
 
     class Air : public AbstractBlock {
         public:
+            //  The compile-time type id of the class.
+            static constexpr EntityType TypeId = EntityType::AIR;
             //  Constructor
             //  The air is a block that can be moved through.
             //  It is used to create the empty spaces in the arena.
@@ -227,6 +263,8 @@ namespace core {
 
     class Player : public Entity {
         public:
+            //  The compile-time type id of the class.
+            static constexpr EntityType TypeId = EntityType::PLAYER;
             //  Constructor
             //  The player is a movable entity that can be moved through.
             //  The player is the main character of the game.
@@ -256,6 +294,8 @@ namespace core {
 
     class Zombie : public AbstractMob {
         public:
+            //  The compile-time type id of the class.
+            static constexpr EntityType TypeId = EntityType::ZOMBIE;
             //  Constructor
             //  The zombie is a mob that moves towards the player and attacks it.
             Zombie(Point position, Arena* arena);
@@ -263,6 +303,8 @@ namespace core {
 
     class Troll: public AbstractMob {
         public:
+            //  The compile-time type id of the class.
+            static constexpr EntityType TypeId = EntityType::TROLL;
             //  Constructor
             //  The troll is a mob that moves towards the player and attacks it.
             //  The troll is stronger than the zombie and has more health points.
@@ -271,6 +313,8 @@ namespace core {
 
     class BabyZombie : public AbstractMob {
         public:
+            //  The compile-time type id of the class.
+            static constexpr EntityType TypeId = EntityType::BABY_ZOMBIE;
             //  Constructor
             //  The baby zombie is a mob that moves towards the player and attacks it.
             //  The baby zombie is weaker but faster than the zombie and has less health points.
@@ -279,11 +323,15 @@ namespace core {
 
     class Monster : public AbstractMob {
         public:
+            //  The compile-time type id of the class.
+            static constexpr EntityType TypeId = EntityType::MONSTER;
             Monster(Point position, Arena* arena);
     };
 
     class Boss : public AbstractMob {
         public:
+            //  The compile-time type id of the class.
+            static constexpr EntityType TypeId = EntityType::BOSS;
             Boss(Point position, Arena* arena);
     };
 
@@ -292,6 +340,8 @@ namespace core {
     //  amount of time.
     class EnergyDrink : public AbstractCollectible{
         public:
+            //  The compile-time type id of the class.
+            static constexpr EntityType TypeId = EntityType::ENERGY_DRINK;
             //  Constructor
             EnergyDrink(Point position, Arena* arena, int hp);
             //  Returns the health points of the energy drink.
@@ -309,6 +359,8 @@ namespace core {
     //  amount of time.
     class StrengthPotion : public AbstractCollectible{
         public:
+            //  The compile-time type id of the class.
+            static constexpr EntityType TypeId = EntityType::STRENGTH_POTION;
             //  Constructor
             StrengthPotion(Point position, Arena* arena, int damage);
             //  Returns the damage of the strength potion.
@@ -325,6 +377,8 @@ namespace core {
     //  It prevents the entity from taking damage for a certain amount of time.
     class Shield : public AbstractCollectible{
         public:
+            //  The compile-time type id of the class.
+            static constexpr EntityType TypeId = EntityType::SHIELD;
             //  Constructor
             Shield(Point position, Arena* arena, int duration);
             //  Let the given entity pick up the shield.
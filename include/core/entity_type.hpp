@@ -3,7 +3,7 @@
 
 namespace core {
 
-    enum class EntityType {
+    enum class EntityType : unsigned char {
         ABSTRACT_ENTITY,// abstract class for all entities
         ABSTRACT_BLOCK,// abstract class for all blocks
         ABSTRACT_MOB,// abstract class for all mobs
@@ -22,6 +22,33 @@ namespace core {
         SHIELD, // temporary protection for player/mob
     };
 
+    //  Returns the bit representing the given type in an ancestry mask.
+    constexpr unsigned int TypeBit(EntityType type) {
+        return 1u << static_cast<unsigned int>(type);
+    }
+
+    //  Returns the ancestry mask of a concrete type, i.e. the bits of the type itself
+    //  and of every abstract type it derives from. Used by Entity::IsType().
+    constexpr unsigned int TypeAncestry(EntityType type) {
+        switch (type) {
+            case EntityType::WALL:
+            case EntityType::AIR:
+                return TypeBit(EntityType::ABSTRACT_ENTITY) | TypeBit(EntityType::ABSTRACT_BLOCK) | TypeBit(type);
+            case EntityType::ZOMBIE:
+            case EntityType::TROLL:
+            case EntityType::BABY_ZOMBIE:
+            case EntityType::MONSTER:
+            case EntityType::BOSS:
+                return TypeBit(EntityType::ABSTRACT_ENTITY) | TypeBit(EntityType::ABSTRACT_MOB) | TypeBit(type);
+            case EntityType::ENERGY_DRINK:
+            case EntityType::STRENGTH_POTION:
+            case EntityType::SHIELD:
+                return TypeBit(EntityType::ABSTRACT_ENTITY) | TypeBit(EntityType::ABSTRACT_COLLECTIBLE) | TypeBit(type);
+            default:
+                return TypeBit(EntityType::ABSTRACT_ENTITY) | TypeBit(type);
+        }
+    }
+
 } // namespace core
 
 #endif // CORE_ENTITY_TYPE_HPP
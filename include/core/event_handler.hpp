@@ -3,13 +3,22 @@
 
 #include <core/arena.hpp>
 #include <core/point.hpp>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
 #include <vector>
 
+namespace util {
+    class WorkerPool;
+}
+
 namespace core {
 
     //  Forward declarations
     class Game;
     class Arena;
+    class Entity;
+    class AbstractMob;
     class PlayerBullet;
     class EventHandler;
     class RunEventHandler;
@@ -21,6 +30,55 @@ namespace core {
     class MobGenerateEventHandler;
     class MobMoveEventHandler;
     class CollectiblesEventHandler;
+    class FlowField;
+    class Pathfinder;
+    class DStarLitePathfinder;
+    class CooperativePlanner;
+    class ReservationTable;
+    struct OccupancySnapshot;
+
+    //  The pathfinding work done by MobMoveEventHandler in one tick.
+    struct PathfindingStats {
+        //  The number of path queries made.
+        int Queries = 0;
+        //  The number of nodes expanded by all queries.
+        int Expansions = 0;
+        //  The number of queries that repaired a previous search (D* Lite) instead of starting over.
+        int Repairs = 0;
+        //  The number of nodes re-expanded by those repairs.
+        int RepairExpansions = 0;
+        //  The number of path requests still queued at the end of the tick.
+        int QueueDepth = 0;
+        //  The total and the longest number of ticks the requests served in this tick had waited.
+        int TotalWaitTicks = 0;
+        int MaxWaitTicks = 0;
+        //  The wall time spent serving path requests, in microseconds.
+        int PlanningMicros = 0;
+        //  The number of workers the requests were planned on.
+        int Workers = 0;
+    };
+
+    //  A key press of the player, passed from the UI thread to the tick thread.
+    struct InputCommand {
+        enum class Type : std::uint8_t { MOVE, SHOOT };
+        Type CommandType;
+        //  A PlayerMoveEventHandler::Direction for MOVE, a bullet direction (0-8) for SHOOT.
+        std::uint8_t Direction;
+        //  When the command was pushed, in microseconds of the steady clock.
+        std::int64_t PushedAtMicros;
+    };
+
+    //  How long input commands wait before the tick thread applies them.
+    struct InputLatencyStats {
+        //  The number of commands applied.
+        long long Commands = 0;
+        //  The number of commands dropped because the queue was full.
+        long long Dropped = 0;
+        //  The total, the longest and the last wait of the applied commands, in microseconds.
+        long long TotalMicros = 0;
+        long long MaxMicros = 0;
+        int LastMicros = 0;
+    };
 
     //  The abstract EventHandler.
     //  Eventhandlers are where your actual code lives. A EventHandler can be fired to exeucte the event.
@@ -49,18 +107,33 @@ namespace core {
     //  The event triggered when Game.Run() is called.
     class RunEventHandler : public EventHandler {
         public:
+            //  The file the handler profiles are written to when the game ends.
+            static constexpr const char* HANDLER_PROFILE_FILE = "./runtime/handler_profile.json";
             //  Constructor.
             RunEventHandler(Game* game);
             //  Destructor.
             ~RunEventHandler();
             //  Triggers the event.
             void Fire() override;
+            //  Runs the game without the terminal UI: initialises it, then fires up to `ticks` ticks
+            //  back to back on the calling thread, without sleeping. Stops early if the game ends.
+            void FireHeadless(long long ticks);
 
         private:
             InitialiseEventHandler* initialiseEventHandler;
             TickEventHandler* tickEventHandler;
             //  Executed when the event is fired.
             void execute();
+            //  Fires the tick event every Game::TICK_MICROS until the game stops.
+            //  Each tick is due at a fixed deadline from the start of the loop, so the time spent
+            //  in a tick does not delay the ticks after it. Runs on the tick thread.
+            void runTickLoop();
+            //  Starts recording a trace if the game options ask for one.
+            void startTrace();
+            //  Stops recording the trace, if any, and writes it to the file in the game options.
+            void finishTrace();
+            //  Logs the duration histograms of the handlers, and writes them to HANDLER_PROFILE_FILE.
+            void writeHandlerProfiles();
     };
 
     class InitialiseEventHandler : public EventHandler {
@@ -104,13 +177,18 @@ namespace core {
         private:
             //  Executed when the event is fired.
             void execute();
-            //  The internal PlayerMoveEventHandler. This event will be exposed to UI and NOT
-            //  triggered by the tick event.
+            //  Applies the input commands queued by the UI thread since the last tick, in the
+            //  order they were pushed, and records how long they waited.
+            void applyInput();
+            //  The internal PlayerMoveEventHandler. This event is NOT triggered by the tick event,
+            //  but fired for each move command the UI queues.
             PlayerMoveEventHandler* playerMoveEventHandler;
-            //  The internal PlayerShootEventHandler. This event will be exposed to UI.
+            //  The internal PlayerShootEventHandler. Fired for each shoot command the UI queues.
             PlayerShootEventHandler* playerShootEventHandler;
             //  The internal BulletMoveEventHandler. This event will be triggered by the tick event.
             BulletMoveEventHandler* bulletMoveEventHandler;
+            //  The latency statistics of the input commands applied so far.
+            InputLatencyStats inputLatencyStats;
     };
     
     //  Player shooting event handler
@@ -172,27 +250,89 @@ namespace core {
         public:
             //  Constructor
             MobMoveEventHandler(Game* game);
+            //  Destructor
+            ~MobMoveEventHandler();
             void Fire() override;
+            //  Returns the pathfinding work done in the last tick.
+            PathfindingStats GetLastTickStats() const;
 
         private:
             //  Executed when the event is fired.
             void execute();
+            //  Sets the next step of every mob from the shared flow fields.
+            //  Used when the game runs with PathfindingAlgorithm::FLOW_FIELD.
+            void followFlowFields(const std::vector<Entity*>& entities, Point playerPos);
+            //  Finds a path for every mob with a separate search, through a queue of path requests.
+            //  Used when the game runs with any other algorithm.
+            void findPathsPerMob(const std::vector<Entity*>& entities, Point playerPos);
+            //  The distance field towards the player, shared by all mobs.
+            FlowField* playerField;
+            //  The distance field towards every energy drink, used by mobs at 1 HP.
+            FlowField* energyDrinkField;
+            //  The occupancy of the arena, refreshed every tick before planning.
+            OccupancySnapshot* snapshot;
             //  The player's previous position. Used to check if the player has moved
             //  and if pathfinding is needed. Initial value is (-1, -1) to ensure
             //  pathfinding must be done at the start.
             Point playerPrevPos;
             int prevMobCount;
-            //  Finds the shortest path from start to end on the given arena using A* algorithm.
-            //  Returns a list of points representing the path, where the first point is
-            //  the one closest to the start and the last point is the one closest to the end.
-            //  The path does not include the start and end points.
-            //  Returns an empty list if no path is found.
-            static std::list<Point> findPath(Arena* arena, Point start, Point end);
+            //  A path request being served. Filled in on the tick thread, planned on a worker,
+            //  then committed to the mob on the tick thread again.
+            struct PathRequest {
+                AbstractMob* Mob;
+                Point Start;
+                Point Target;
+                //  The pathfinder to plan with. nullptr for cooperative planning.
+                Pathfinder* Engine;
+                std::list<Point> Path;
+                int Expansions = 0;
+                bool Incremental = false;
+            };
+            //  Plans the requests of a batch, in parallel on the workers when possible, then
+            //  commits the paths and their statistics.
+            void planBatch(std::vector<PathRequest>& batch);
+            //  Finds the shortest path of the request with its pathfinder, reading the occupancy
+            //  from the current snapshot. Walls and other mobs are obstacles.
+            //  The path does not include the start and ends at the target; it is empty if no path
+            //  is found. Safe to run on several workers at once, for different mobs.
+            void findPath(PathRequest& request);
+            //  The threads planning paths in parallel. Created on the first per-mob planning pass.
+            util::WorkerPool* workers = nullptr;
+            //  The reusable search engines, one per worker. Created on the first per-mob planning
+            //  pass, since the hierarchical one needs the loaded arena. Unused when the game runs
+            //  with PathfindingAlgorithm::FLOW_FIELD, D_STAR_LITE or COOPERATIVE.
+            std::vector<Pathfinder*> pathfinders;
+            //  The D* Lite searches, one per mob as each one repairs its own previous search.
+            //  Keyed by mob ID.
+            std::unordered_map<int, DStarLitePathfinder*> mobPathfinders;
+            //  Returns the pathfinder to use for the mob, creating it if needed. For the pathfinders
+            //  shared by all mobs, this is the one of the first worker.
+            //  Must be called on the tick thread. nullptr for cooperative planning.
+            Pathfinder* pathfinderFor(Entity* mob);
+            //  The space-time planner and the paths it has reserved so far. Only created when the
+            //  game runs with PathfindingAlgorithm::COOPERATIVE. Always runs on the tick thread,
+            //  as every path depends on those planned before it.
+            CooperativePlanner* cooperativePlanner = nullptr;
+            ReservationTable* reservations = nullptr;
+            //  Plans and reserves the path of the request through cooperativePlanner.
+            void planCooperatively(PathRequest& request);
+            //  Creates the shared pathfinder selected in the game options.
+            Pathfinder* createPathfinder();
+            //  The total planning time and number of ticks with planning, logged when the game ends.
+            long long totalPlanningMicros = 0;
+            long long planningTicks = 0;
+            //  The mobs waiting for a path, in the order they asked, and the tick each one asked at.
+            //  Requests are served in order until the tick's budget runs out.
+            std::deque<int> pathRequests;
+            std::unordered_map<int, long long> pathRequestTicks;
+            //  Returns where the mob should head to: the player, or the nearest energy drink if
+            //  the mob is about to die.
+            Point chooseTarget(AbstractMob* mob, Point playerPos);
+            //  The pathfinding work done so far in this tick, and in the last complete tick.
+            PathfindingStats tickStats;
+            PathfindingStats lastTickStats;
             //  Returns the manhattan distance between two points.
             inline static int heuristic(Point a, Point b);
-            //  Returns neighbours iff they are within x:[1, ARENA_WIDTH-2] and y:[1, ARENA_HEIGHT-2]
-            //  i.e. not on the border. Includes diagonal neighbours.
-            inline static std::list<Point> getNeighbours(Point point);
     };
 
     //  The event handler that manages all the collectibles.
@@ -2,22 +2,90 @@
 #define CORE_GAME_HPP
 
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <mutex>
+#include <string>
+#include <vector>
 
 #include <core/entity.hpp>
 #include <core/event_handler.hpp>
 #include <core/game_options.hpp>
+#include <util/latency_histogram.hpp>
+#include <util/random.hpp>
+#include <util/spsc_queue.hpp>
+#include <util/triple_buffer.hpp>
 
 namespace core {
 
     //  Forward declarations
     class Arena;
     class EventHandler;
+    class TimerWheel;
     struct GameOptions;
+    struct FrameSnapshot;
+
+    //  The random number streams of a game, one per subsystem. Every stream is independent,
+    //  so a subsystem drawing more or fewer numbers does not change what the others draw.
+    enum class RandomStream {
+        MOB_SPAWN, // where mobs spawn and which type they are
+        COLLECTIBLE_SPAWN, // where collectibles spawn, their type and their strength
+        COUNT // the number of streams, not a stream
+    };
+
+    //  The parts of a tick whose durations are profiled, each with a histogram of its own.
+    enum class ProfiledHandler {
+        TICK, // the whole tick, TickEventHandler
+        INPUT, // the key presses applied, PlayerMoveEventHandler and PlayerShootEventHandler
+        MOB_GENERATE, // MobGenerateEventHandler
+        MOB_MOVE, // MobMoveEventHandler, pathfinding included
+        BULLET_MOVE, // BulletMoveEventHandler
+        COLLECTIBLES, // CollectiblesEventHandler
+        PUBLISH_FRAME, // the frame handed to the UI
+        COUNT // the number of profiled handlers, not a handler
+    };
+
+    //  Returns the display name of a profiled handler, e.g. "MobMove".
+    const char* GetProfiledHandlerName(ProfiledHandler handler);
+
+    //  How well the tick loop keeps to its fixed timestep.
+    struct TickTimingStats {
+        //  The number of ticks run.
+        long long Ticks = 0;
+        //  The number of ticks whose work took longer than the tick period, and by how much
+        //  in total and at most, in microseconds.
+        long long Overruns = 0;
+        long long TotalOverrunMicros = 0;
+        long long MaxOverrunMicros = 0;
+        //  The work time of the last tick, in microseconds.
+        int LastTickMicros = 0;
+        //  The number of ticks started late, right after the previous one instead of at their
+        //  deadline, and the number of ticks dropped because the loop was too far behind.
+        long long LateTicks = 0;
+        long long DroppedTicks = 0;
+    };
+
+    //  How the redraws of the UI are paced.
+    struct RedrawStats {
+        //  The number of frames published with changes, each asking for a redraw.
+        long long Requested = 0;
+        //  The number of those requests folded into a redraw that was already pending, or put
+        //  off to keep to the maximum frame rate.
+        long long Coalesced = 0;
+        //  The number of frames published without any change, which asked for no redraw.
+        long long Unchanged = 0;
+        //  The number of frames the UI built, and the number of times it drew the arena of the last
+        //  one built again because the latest frame had not changed since.
+        long long Drawn = 0;
+        long long Reused = 0;
+    };
 
     //  The main object representing the whole round.
     class Game {
         public:
+            //  The fixed length of a tick, in microseconds. The game runs at 50 ticks per second.
+            static constexpr int TICK_MICROS = 20000;
+
             //  Constructor
             Game(GameOptions* options);
             //  Destructor
@@ -25,13 +93,20 @@ namespace core {
 
             //  The entry point of the game. Returns the final score.
             int Run();
+            //  The entry point of a game without the terminal UI, for simulations and load tests.
+            //  Runs at most `ticks` ticks back to back on the calling thread, without sleeping,
+            //  and returns the final score. The game is fully terminated when this returns.
+            int RunHeadless(long long ticks);
             //  Terminates the game. Takes one optional argument: reason.
             //  By default, the reason is 0 (game over).
             //  Other acceptable values:
             //      1: player quit
+            //      2: tick limit of a headless game reached
             void Terminate(int reason = 0);
             //  Returns true if the game is running.
             bool IsRunning() const;
+            //  Returns true if the game runs without the terminal UI.
+            bool IsHeadless() const;
             //  Returns true if the game is initialised.
             bool IsInitialised() const;
             //  Signals the game that initialisation is complete.
@@ -44,7 +119,7 @@ namespace core {
             void ChangeScore(int delta);
             int GetScore();
             //  Returns the reason for termination.
-            //  0: game over; 1: player quit;
+            //  0: game over; 1: player quit; 2: tick limit reached;
             int GetTerminateReason() const;
             
             //  Initialise the game arena. If the arena is provided in the GameOptions,
@@ -61,10 +136,57 @@ namespace core {
             PlayerShootEventHandler* PlayerShootEventHandlerPtr = nullptr;
             //  The exposed BulletMoveEventHandler.
             BulletMoveEventHandler* BulletMoveEventHandlerPtr = nullptr;
-            //  Increments the game clock by 1 tick.
+            //  The exposed MobMoveEventHandler. Used to read the pathfinding statistics.
+            MobMoveEventHandler* MobMoveEventHandlerPtr = nullptr;
+            //  Increments the game clock by 1 tick, and advances the wakeup scheduler with it.
             void IncrementGameClock();
             //  Returns the game clock.
             long long GetGameClock() const;
+            //  Returns the scheduler of entity wakeups, keyed on the game clock.
+            //  Event handlers take the entities that are due from it instead of polling them all.
+            TimerWheel* GetScheduler() const;
+            //  Returns the random number generator of the given subsystem. Each stream must only be
+            //  used by one thread at a time.
+            util::Random& GetRandom(RandomStream stream);
+            //  Returns the seed the random number streams were created from.
+            std::uint64_t GetSeed() const;
+            //  Returns the timing statistics of the tick loop.
+            TickTimingStats GetTickTimingStats();
+            //  Updates the timing statistics of the tick loop. Only called by the tick loop.
+            void SetTickTimingStats(const TickTimingStats& stats);
+            //  Queues a key press of the player, to be applied at the start of the next tick.
+            //  Only called by the UI thread. Returns false if the queue is full and the command
+            //  was dropped.
+            bool PushInput(InputCommand::Type type, int direction);
+            //  Takes the oldest queued input command. Returns false if there is none.
+            //  Only called by the tick thread.
+            bool PopInput(InputCommand& command);
+            //  Returns the latency statistics of the input commands.
+            InputLatencyStats GetInputLatencyStats();
+            //  Updates the latency statistics of the input commands. Only called by the tick thread.
+            void SetInputLatencyStats(const InputLatencyStats& stats);
+            //  Copies the arena and the state of the player into a frame and publishes it to the UI.
+            //  Only called by the tick thread, at the end of a tick. A frame that does not differ
+            //  from the one published before it is not published; returns true if it was.
+            bool PublishFrame();
+            //  Returns the latest published frame. It stays unchanged until the next call, however
+            //  many frames are published in between. Only called by the UI thread.
+            const FrameSnapshot& GetLatestFrame();
+            //  Records a frame published by the tick thread, and returns true if the UI should be
+            //  asked to redraw now. A redraw is asked for only when a frame has changed since the
+            //  last one asked for, no redraw is pending already, and the maximum frame rate allows.
+            //  A change that cannot be drawn yet is drawn by a later call. Only called by the tick thread.
+            bool RequestRedraw(bool frameChanged);
+            //  Marks the pending redraw as done. `reused` is true if the UI drew the arena of its last
+            //  frame again instead of building a new one. Only called by the UI thread.
+            void MarkFrameDrawn(bool reused);
+            //  Returns the statistics of the redraws.
+            RedrawStats GetRedrawStats();
+            //  Returns the histogram of the durations of a profiled handler over the game, in
+            //  microseconds. Only the tick thread records into it; any thread may read it.
+            util::LatencyHistogram& GetHandlerProfile(ProfiledHandler handler);
+            //  Writes the handler profiles to a file as JSON. Returns false if it cannot be written.
+            bool WriteHandlerProfiles(const std::string& path);
 
         private:
             //  The score. Initial score is 0.
@@ -76,7 +198,9 @@ namespace core {
             //  The flag indicating whether the arena is created using new in this class.
             bool arenaIsDynamicallyCreated = false;
             //  The root event.
-            EventHandler* runEventHandler;
+            EventHandler* runEventHandler = nullptr;
+            //  The flag indicating whether the game runs without the terminal UI.
+            bool headless = false;
             //  The game options.
             GameOptions* options;
             //  The flag indicating whether the game is running.
@@ -89,6 +213,44 @@ namespace core {
             std::mutex gameMutex;
             //  The clock of the game. Unit: ticks.
             std::atomic<long long> gameClock = 0;
+            //  The scheduler of entity wakeups.
+            TimerWheel* scheduler;
+            //  The seed of the game, and the random number streams split off from it.
+            std::uint64_t seed;
+            std::vector<util::Random> randomStreams;
+            //  The timing statistics of the tick loop. Guarded by gameMutex.
+            TickTimingStats tickTimingStats;
+            //  The capacity of the input queue. A player cannot press this many keys in one tick.
+            static constexpr std::size_t INPUT_QUEUE_CAPACITY = 64;
+            //  The input commands from the UI thread to the tick thread.
+            util::SpscQueue<InputCommand, INPUT_QUEUE_CAPACITY>* inputQueue;
+            //  The number of input commands dropped because the queue was full.
+            std::atomic<long long> droppedInputs = 0;
+            //  The latency statistics of the input commands, except the drops. Guarded by gameMutex.
+            InputLatencyStats inputLatencyStats;
+            //  The frames passed from the tick thread to the UI thread.
+            util::TripleBuffer<FrameSnapshot>* frames;
+            //  The version of the last frame published, and the state of the player and the score
+            //  in it. Only used by the tick thread.
+            long long frameVersion = 0;
+            Point publishedPlayerPosition = {-1, -1};
+            int publishedPlayerHp = -1;
+            int publishedPlayerDamage = -1;
+            int publishedScore = -1;
+            //  Whether a redraw was asked for and the UI has not drawn since.
+            std::atomic<bool> framePending = false;
+            //  Whether a frame changed since the last redraw asked for, and when that was.
+            //  Only used by the tick thread.
+            bool redrawWanted = false;
+            std::chrono::steady_clock::time_point lastRedrawRequest;
+            //  The duration histograms of the profiled handlers, one per ProfiledHandler.
+            util::LatencyHistogram* handlerProfiles;
+            //  The statistics of the redraws. Counted by both threads.
+            std::atomic<long long> redrawsRequested = 0;
+            std::atomic<long long> redrawsCoalesced = 0;
+            std::atomic<long long> framesUnchanged = 0;
+            std::atomic<long long> framesDrawn = 0;
+            std::atomic<long long> framesReused = 0;
             //  Records the reason for termination.
             int terminateReason = -1;
     };
@@ -2,6 +2,7 @@
 #define CORE_GAME_OPTIONS_HPP
 
 #include <set>
+#include <string>
 
 #include <core/entity_type.hpp>
 
@@ -9,7 +10,23 @@ namespace core {
 
     //  Forward declarations
     class Arena;
-    
+
+    //  The algorithms available for mob pathfinding.
+    enum class PathfindingAlgorithm {
+        FLOW_FIELD, // one shared distance field from the player, mobs step down its gradient
+        A_STAR, // a separate A* search for every mob
+        JUMP_POINT_SEARCH, // a separate Jump Point Search for every mob, fewer expansions than A* and shortest paths
+        HIERARCHICAL, // HPA* over clusters precomputed at map load, only the first cluster hop is searched cell by cell
+        D_STAR_LITE, // a D* Lite search kept by every mob, repaired as the player and other mobs move
+        COOPERATIVE, // mobs plan one after another over space and time, reserving their paths so they do not collide
+    };
+
+    //  The ways the UI can draw the arena.
+    enum class ArenaRenderer {
+        ELEMENTS, // a styled ftxui element per cell, laid out by ftxui; rows are rebuilt only when they change
+        DIRECT, // cells written straight into the screen buffer, without an element or a layout pass per cell
+    };
+
     //  The options for the game.
     struct GameOptions {
         //  The initial health of the player.
@@ -28,6 +45,35 @@ namespace core {
         //  The game difficulty level.
         //  0 = Easy, 1 = Medium, 2 = Hard, 3 = Custom
         int DifficultyLevel;
+        //  The algorithm used by mobs to find their way to the player.
+        PathfindingAlgorithm MobPathfinding = PathfindingAlgorithm::FLOW_FIELD;
+        //  The time that mob pathfinding may take in one tick, in microseconds. 0 means no limit.
+        //  Only used by the per-mob algorithms. Path requests that miss the budget wait in a queue
+        //  for the next ticks, and the mob keeps following its previous path meanwhile.
+        int PathfindingBudgetMicros = 2000;
+        //  The number of threads planning mob paths in parallel, including the tick thread.
+        //  0 means one per hardware thread. Cooperative planning always runs on the tick thread.
+        int PathfindingWorkers = 0;
+        //  The number of missed ticks the tick loop may run back to back to catch up after
+        //  falling behind its fixed timestep. Missed ticks beyond that are dropped. 0 means
+        //  missed ticks are always dropped, so the game slows down rather than speeds up.
+        int MaxCatchUpTicks = 0;
+        //  The seed of the random number generator. 0 seeds it from the clock, so that every
+        //  game is different. A fixed seed makes headless runs repeatable.
+        unsigned long long Seed = 0;
+        //  How the UI draws the arena. Both draw the same picture. The game sets it from the
+        //  SHOOT_RENDERER environment variable (direct or elements) when that is set.
+        ArenaRenderer Renderer = ArenaRenderer::ELEMENTS;
+        //  The maximum number of frames the UI is asked to draw per second. 0 means one per tick.
+        //  Changes between two frames are drawn together in the later one. The game sets it from
+        //  the SHOOT_MAX_FPS environment variable when that is set.
+        int MaxFramesPerSecond = 30;
+        //  The file the game writes a Chrome trace of its ticks, event handlers, pathfinding and
+        //  frames to when it ends. Empty means no trace is recorded.
+        std::string TraceFile = "";
+        //  Whether the UI starts with the panel of handler times shown instead of the
+        //  instructions. The player can toggle it with P either way.
+        bool ShowHandlerProfile = false;
     };
 
     //  Built-in GameOptions
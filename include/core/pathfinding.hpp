@@ -0,0 +1,299 @@
+#ifndef CORE_PATHFINDING_HPP
+#define CORE_PATHFINDING_HPP
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <core/arena.hpp>
+#include <core/point.hpp>
+
+namespace core {
+
+    //  A distance field over the arena, computed by a breadth-first pass from one or more sources.
+    //  Each cell stores the number of steps to the nearest source on the 8-connected grid, so any
+    //  number of mobs can share one field and reach a source by stepping to a closer neighbour.
+    //  Only walls are treated as obstacles, since they are the only static entities.
+    class FlowField {
+        public:
+            //  The distance of cells that cannot reach any source.
+            static const int UNREACHABLE = -1;
+
+            //  Constructor. The field is empty (every cell unreachable) until computed.
+            FlowField();
+            //  Recomputes the field from the given sources.
+            void Compute(const OccupancySnapshot& snapshot, const std::vector<Point>& sources);
+            //  Returns true if the field was last computed from exactly the given sources.
+            bool IsComputedFrom(const std::vector<Point>& sources) const;
+            //  Returns the number of steps from p to the nearest source, or UNREACHABLE.
+            int GetDistance(Point p) const;
+            //  Returns the neighbour of `from` that is closest to a source and can be entered
+            //  by a mob (air, the player or a collectible). Returns `from` if no such neighbour
+            //  is closer to a source than `from` itself.
+            Point NextStep(Point from, const OccupancySnapshot& snapshot) const;
+
+        private:
+            //  The distances, indexed by y * ARENA_WIDTH + x.
+            int distance[ARENA_HEIGHT * ARENA_WIDTH];
+            //  The BFS queue. Every cell is enqueued at most once.
+            int queue[ARENA_HEIGHT * ARENA_WIDTH];
+            //  The sources the field was last computed from.
+            std::vector<Point> sources;
+    };
+
+    //  The base of the single-query pathfinders over the arena grid.
+    //  Holds the per-cell scratch buffers shared by the search algorithms. The cost and
+    //  cameFrom arrays are tagged with a generation stamp, so a new query only bumps the
+    //  generation instead of clearing them, and the open list is a binary heap kept in a
+    //  vector whose capacity is reused across queries. Nothing is allocated per query
+    //  except the returned path.
+    class Pathfinder {
+        public:
+            //  Constructor
+            Pathfinder();
+            virtual ~Pathfinder() = default;
+            //  Finds the shortest path from start to end, treating walls and mobs as obstacles.
+            //  The path excludes the start and includes the end.
+            //  Returns an empty list if no path is found.
+            virtual std::list<Point> FindPath(const OccupancySnapshot& snapshot, Point start, Point end) = 0;
+            //  Returns the number of nodes expanded by the last query.
+            int GetLastExpansions() const;
+            //  Returns true if the last query repaired the result of a previous one instead of
+            //  searching from scratch. Only incremental pathfinders ever do.
+            virtual bool WasLastQueryIncremental() const;
+
+        protected:
+            typedef std::pair<int, int> Node;
+            //  The cost from the start to each cell. Only valid where stamp == generation.
+            int cost[ARENA_HEIGHT * ARENA_WIDTH];
+            //  The cell each cell was reached from. Only valid where stamp == generation.
+            int cameFrom[ARENA_HEIGHT * ARENA_WIDTH];
+            //  The generation each cell was last written in.
+            unsigned int stamp[ARENA_HEIGHT * ARENA_WIDTH];
+            //  The generation of the current query.
+            unsigned int generation = 0;
+            //  The open list, as a min-heap of (priority, cell).
+            std::vector<Node> open;
+            //  The number of nodes expanded by the last query.
+            int lastExpansions = 0;
+
+            //  Starts a new query from the given cell.
+            void beginQuery(int startIndex);
+            //  Records that `next` is reached from `current` with the given cost, and pushes it
+            //  to the open list with the given priority, if this improves on its known cost.
+            void relax(int current, int next, int newCost, int priority);
+            //  Pops the cell with the lowest priority from the open list.
+            int popOpen();
+            //  Builds the path from cameFrom, from start (excluded) to end (included).
+            //  Consecutive cells in cameFrom may be several steps apart as long as they lie
+            //  on a straight or diagonal line, so jump points expand to every cell in between.
+            std::list<Point> reconstructPath(int startIndex, int endIndex) const;
+    };
+
+    //  A plain A* search over the 8-connected arena.
+    class AStarPathfinder : public Pathfinder {
+        public:
+            std::list<Point> FindPath(const OccupancySnapshot& snapshot, Point start, Point end) override;
+            //  Returns true if the last query reached the cell. A query that found no path has
+            //  reached every cell a mob can walk to from its start.
+            bool WasReached(Point p) const;
+    };
+
+    //  Jump Point Search over the 8-connected arena.
+    //  Symmetric paths on the uniform-cost grid are pruned by jumping along straight and diagonal
+    //  lines until a forced neighbour or the goal is met, so only the jump points enter the
+    //  open list. Diagonal moves may cut corners, as they can with A*.
+    class JumpPointPathfinder : public Pathfinder {
+        public:
+            std::list<Point> FindPath(const OccupancySnapshot& snapshot, Point start, Point end) override;
+
+        private:
+            //  Jumps from (x, y) in the direction (dx, dy). Returns the index of the jump point,
+            //  or -1 if the line runs into an obstacle first.
+            int jump(const OccupancySnapshot& snapshot, int x, int y, int dx, int dy, Point end) const;
+    };
+
+    //  The abstract graph of the walls of an arena, used by hierarchical pathfinding (HPA*).
+    //  The arena is cut into square clusters. Entrances are placed along the borders shared
+    //  by neighbouring clusters, and each entrance cell becomes an abstract node. Nodes are
+    //  linked across borders with cost 1, and within a cluster with their distance inside
+    //  that cluster. Only walls are considered, so the graph is built once when the map is
+    //  loaded and never changes afterwards.
+    class ClusterGraph {
+        public:
+            //  The width and height of a cluster, in cells.
+            static const int CLUSTER_SIZE = 10;
+            //  An edge of the abstract graph. Nodes are identified by their cell index.
+            struct Edge {
+                int To;
+                int Cost;
+            };
+
+            //  Constructor. Builds the graph from the walls in the snapshot.
+            ClusterGraph(const OccupancySnapshot& snapshot);
+            //  Returns the cluster containing p.
+            int GetClusterOf(Point p) const;
+            //  Returns the cluster containing the cell.
+            int GetClusterOf(int cell) const;
+            //  Returns the abstract nodes in the given cluster, as cell indices.
+            const std::vector<int>& GetNodesInCluster(int cluster) const;
+            //  Returns the edges leaving the abstract node at the given cell.
+            //  Returns an empty list if the cell is not an abstract node.
+            const std::vector<Edge>& GetEdges(int cell) const;
+            //  Returns the number of abstract nodes.
+            int GetNodeCount() const;
+            //  Computes the distance from p to every cell of its cluster, moving only inside
+            //  the cluster. `distance` is indexed by cell; cells outside the cluster are left as is,
+            //  unreachable cells inside it are set to -1.
+            void ComputeClusterDistances(Point p, std::vector<int>& distance) const;
+
+        private:
+            //  The number of clusters in each row.
+            int clustersPerRow;
+            //  Whether each cell is a wall.
+            bool walls[ARENA_HEIGHT][ARENA_WIDTH];
+            //  The abstract nodes of each cluster.
+            std::vector<std::vector<int>> clusterNodes;
+            //  The edges of each cell. Empty for cells that are not abstract nodes.
+            std::vector<std::vector<Edge>> edges;
+            //  The number of abstract nodes.
+            int nodeCount = 0;
+            //  Adds the entrances along the border between two neighbouring clusters.
+            //  (ax, ay) and (bx, by) walk the two sides of the border, step by (dx, dy).
+            void addEntrances(int ax, int ay, int bx, int by, int dx, int dy, int length);
+            //  Adds an abstract node at the cell, if it is not one already.
+            void addNode(int cell);
+            //  Adds an edge from one node to another, keeping the lower cost if it exists.
+            void addEdge(int from, int to, int cost);
+    };
+
+    //  Hierarchical pathfinding (HPA*) over the cluster graph of the arena.
+    //  The start and end are linked to the entrances of their clusters, the abstract graph
+    //  is searched, and only the first hop (from the start into the next cluster) is refined
+    //  into a concrete path with A*, which is where the mobs actually are. Falls back to a
+    //  plain A* search when start and end share a cluster, when no graph is available, or when
+    //  the abstract route is blocked.
+    class HierarchicalPathfinder : public Pathfinder {
+        public:
+            //  Constructor. The graph is owned by the arena; pass nullptr to always use A*.
+            HierarchicalPathfinder(const ClusterGraph* graph);
+            std::list<Point> FindPath(const OccupancySnapshot& snapshot, Point start, Point end) override;
+
+        private:
+            const ClusterGraph* graph;
+            //  Refines abstract hops into concrete paths.
+            AStarPathfinder refiner;
+            //  The distances inside the start and end clusters, indexed by cell.
+            std::vector<int> startDistance;
+            std::vector<int> endDistance;
+    };
+
+    //  D* Lite, an incremental search that repairs its previous result instead of starting over.
+    //  One instance serves one mob, and must be queried with the same start (the mob) for its
+    //  search tree to be reused. The tree is rooted at the mob and grows towards the end (the
+    //  player), so a player moving by a cell only shifts the key modifier, and cells that became
+    //  blocked or free since the last query are repaired locally. The cost of a repair thus
+    //  scales with the change rather than the map. When the mob itself moves, the root changes
+    //  and the search starts over; mobs move far less often than the player does.
+    class DStarLitePathfinder : public Pathfinder {
+        public:
+            std::list<Point> FindPath(const OccupancySnapshot& snapshot, Point start, Point end) override;
+            bool WasLastQueryIncremental() const override;
+
+        private:
+            //  The sum of heuristic shifts after which the search is restarted, so keys never overflow.
+            static const int MAX_KEY_MODIFIER = 1 << 16;
+            //  The one-step lookahead of each cell: the lowest g among its neighbours, plus one.
+            //  g itself is kept in cost. Both are only valid where stamp == generation.
+            int rhs[ARENA_HEIGHT * ARENA_WIDTH];
+            //  The key each cell was last queued with, or -1 if it is not in the open list.
+            //  Open list entries that do not match are stale and skipped.
+            int queuedKey[ARENA_HEIGHT * ARENA_WIDTH];
+            //  The occupancy the current search tree was built against.
+            OccupancySnapshot last;
+            //  The cell the search tree is rooted at (the mob), and the cell it searches for.
+            int rootIndex = -1;
+            int targetIndex = -1;
+            //  The key modifier, i.e. the sum of heuristic shifts since the search started.
+            int keyModifier = 0;
+            bool lastQueryIncremental = false;
+
+            //  Returns true if the cell can be walked through by this mob.
+            bool isOpenCell(const OccupancySnapshot& snapshot, int cell) const;
+            //  Initialises g and rhs of the cell, if not done in this generation yet.
+            void touch(int cell);
+            //  Returns the key of the cell, packed as (k1, k2) in one int.
+            int calculateKey(int cell) const;
+            //  Recomputes rhs of the cell, and queues it if it is inconsistent.
+            void updateVertex(const OccupancySnapshot& snapshot, int cell);
+            //  Expands inconsistent cells until the target is consistent and no cheaper key is open.
+            void computeShortestPath(const OccupancySnapshot& snapshot);
+    };
+
+    //  Records which mob will be in which cell and when, for cooperative pathfinding.
+    //  Each reservation holds one cell over an inclusive range of ticks. The ranges of two mobs
+    //  in the same cell must not even touch, since mobs move one after another within a tick
+    //  and a mob cannot step into a cell that is only vacated later in the same tick.
+    class ReservationTable {
+        public:
+            //  Constructor
+            ReservationTable();
+            //  Returns true if no mob other than the given one holds the cell at any tick in [from, to].
+            bool IsFree(int cell, long long from, long long to, int mobId) const;
+            //  Reserves the cell for the mob over [from, to].
+            void Reserve(int cell, long long from, long long to, int mobId);
+            //  Drops every reservation of the mob.
+            void Release(int mobId);
+            //  Drops the reservations that ended before the given tick.
+            void Prune(long long now);
+
+        private:
+            struct Reservation {
+                long long From;
+                long long To;
+                int MobId;
+            };
+            //  The reservations of each cell.
+            std::vector<std::vector<Reservation>> reservations;
+            //  The cells each mob has reserved, so that they can be released.
+            std::unordered_map<int, std::vector<int>> cellsByMob;
+    };
+
+    //  Cooperative A* (WHCA*) over space and time. Mobs plan one after another, each one
+    //  avoiding the (cell, tick) slots reserved by those before it and then reserving its own
+    //  path, so the paths of a wave do not collide. A step may be a wait, which makes room for
+    //  another mob to pass. Only the first WINDOW steps are planned against the reservations,
+    //  the rest of the path follows the distance field towards the end.
+    class CooperativePlanner {
+        public:
+            //  The number of steps planned against the reservations.
+            static const int WINDOW = 16;
+
+            //  Constructor
+            CooperativePlanner();
+            //  Plans a path for the mob from start to end, and replaces the mob's reservations
+            //  with it. The mob can make its first step at firstStepTick, then one every
+            //  ticksPerStep ticks. A wait appears in the path as the cell the mob is already in.
+            //  `field` must hold the distances to end, and is used as the heuristic.
+            //  The path excludes the start and includes the end.
+            //  Returns an empty list if no path is found.
+            std::list<Point> PlanPath(const OccupancySnapshot& snapshot, const FlowField& field, ReservationTable& table,
+                int mobId, Point start, Point end, long long now, long long firstStepTick, int ticksPerStep);
+            //  Returns the number of nodes expanded by the last query.
+            int GetLastExpansions() const;
+
+        private:
+            typedef std::pair<int, int> Node;
+            //  The per-state buffers, indexed by step * cells + cell, like those of Pathfinder.
+            std::vector<int> cost;
+            std::vector<int> cameFrom;
+            std::vector<unsigned int> stamp;
+            unsigned int generation = 0;
+            std::vector<Node> open;
+            int lastExpansions = 0;
+    };
+
+}
+
+#endif // CORE_PATHFINDING_HPP
@@ -0,0 +1,75 @@
+#ifndef CORE_TIMER_WHEEL_HPP
+#define CORE_TIMER_WHEEL_HPP
+
+#include <mutex>
+#include <vector>
+
+#include <core/entity_type.hpp>
+
+namespace core {
+
+    //  Forward declarations
+    class Entity;
+
+    //  A hierarchical timer wheel of entity wakeups, keyed on the game clock.
+    //  Entities are scheduled for the tick they next need attention at, and each event handler
+    //  takes the entities of its types once they are due, instead of polling every entity
+    //  every tick. The cost of a tick therefore grows with the number of entities due, not with
+    //  the number of entities alive.
+    //  Level 0 has one slot per tick for the next 64 ticks. Every level above has 64 slots too,
+    //  each spanning the whole level below, and a slot is moved down a level when the clock
+    //  reaches it. Wakeups further away than the top level are kept aside until the clock gets
+    //  there. The wakeup of an entity is stored in Entity::WakeupTick, so its slot can be found
+    //  without any lookup.
+    //  All methods are thread-safe, so entities can be woken up from the UI thread.
+    class TimerWheel {
+        public:
+            //  The number of slots of a level is 2^SLOT_BITS.
+            static constexpr int SLOT_BITS = 6;
+            static constexpr int SLOT_COUNT = 1 << SLOT_BITS;
+            static constexpr int LEVEL_COUNT = 4;
+            //  The WakeupTick of an entity that is due but not taken yet.
+            static constexpr long long DUE = -1;
+            //  The WakeupTick of an entity that is not scheduled.
+            static constexpr long long IDLE = -2;
+
+            //  Constructor. `now` is the current tick of the game clock.
+            TimerWheel(long long now = 0);
+            //  Schedules the entity to be due at the given tick, replacing its previous wakeup.
+            //  A tick that is not in the future makes the entity due at once.
+            void Schedule(Entity* entity, long long tick);
+            //  Makes the entity due at once, e.g. because it died or was picked up.
+            void WakeUp(Entity* entity);
+            //  Cancels the wakeup of the entity. Must be called before deleting an entity that
+            //  may still be scheduled.
+            void Cancel(Entity* entity);
+            //  Advances the wheel to the given tick. Entities scheduled up to that tick become due.
+            void Advance(long long now);
+            //  Moves the due entities of the given type (or deriving from it) to `due`, in the
+            //  order they became due. They are no longer scheduled afterwards.
+            void TakeDue(EntityType type, std::vector<Entity*>& due);
+            //  Returns the number of entities scheduled or due.
+            int GetScheduledCount() const;
+
+        private:
+            mutable std::mutex mutex;
+            //  The tick the wheel has been advanced to.
+            long long current;
+            std::vector<Entity*> slots[LEVEL_COUNT][SLOT_COUNT];
+            //  The wakeups beyond the top level.
+            std::vector<Entity*> overflow;
+            //  The entities that are due but not taken yet.
+            std::vector<Entity*> due;
+            //  The number of entities scheduled or due.
+            int scheduledCount = 0;
+            //  Returns the slot a wakeup at the given tick is in: the one of the lowest level whose
+            //  span still covers it, i.e. the level above which the tick and the current tick have
+            //  the same digits.
+            std::vector<Entity*>& slotOf(long long tick);
+            //  Removes the entity from wherever it is scheduled. Assumes the mutex is held.
+            void unschedule(Entity* entity);
+    };
+
+}
+
+#endif // CORE_TIMER_WHEEL_HPP
@@ -0,0 +1,21 @@
+#ifndef UI_ARENA_RENDERER_HPP
+#define UI_ARENA_RENDERER_HPP
+
+#include <core/arena.hpp>
+#include <ftxui/dom/elements.hpp>
+
+namespace ui {
+
+    //  Returns true if the cell at (x, y) is on a line of fire of the player, i.e. in the same
+    //  row, column or diagonal. Such cells are drawn on a grey background, except collectibles.
+    bool IsOnLineOfFire(const core::FrameSnapshot& frame, int x, int y);
+
+    //  Returns an element that draws the arena of the frame straight into the screen buffer,
+    //  one pixel per cell, without an element or a layout pass per cell.
+    //  The frame must stay unchanged until the element is drawn. If `drawMicros` is given, the
+    //  time spent drawing is added to it.
+    ftxui::Element DirectArena(const core::FrameSnapshot& frame, long long* drawMicros = nullptr);
+
+}
+
+#endif // UI_ARENA_RENDERER_HPP
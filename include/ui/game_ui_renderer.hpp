@@ -3,6 +3,10 @@
 
 #include <core/game.hpp>
 #include <ftxui/component/component.hpp>
+#include <ftxui/screen/screen.hpp>
+
+#include <string>
+#include <vector>
 
 namespace ui {
 
@@ -18,6 +22,36 @@ namespace ui {
         private:
             core::Game* game;
             ftxui::Component draw();
+
+            //  The arena rows built for earlier frames, reused until they change. A row is rebuilt
+            //  when its version in the frame changes, and all rows are rebuilt when the player
+            //  moves, since the highlighted lines of fire move with it.
+            std::vector<ftxui::Element> rowElements;
+            std::vector<long long> rowVersions;
+            core::Point highlightOrigin = {-1, -1};
+            //  The arena of the last frame built, drawn again as long as the latest frame has its version.
+            ftxui::Element lastArena;
+            long long lastFrameVersion = -1;
+            //  Whether the panel of handler times is shown instead of the instructions.
+            bool showHandlerProfile;
+            //  The time spent building the element tree of the frames, in microseconds.
+            long long frameCount = 0;
+            long long totalBuildMicros = 0;
+            long long rebuiltRows = 0;
+            //  The bytes ftxui writes to the terminal for the arena of the frames, measured by
+            //  printing the arena alone into a screen of its size. That draws the arena a second
+            //  time, so only one frame in ARENA_BYTES_SAMPLE_INTERVAL is measured.
+            static constexpr int ARENA_BYTES_SAMPLE_INTERVAL = 32;
+            long long totalArenaBytes = 0;
+            long long sampledFrames = 0;
+            ftxui::Screen arenaScreen = ftxui::Screen(ARENA_WIDTH, ARENA_HEIGHT);
+
+            //  Builds the arena of the frame, and counts the time spent and the bytes printed.
+            ftxui::Element renderArena(const core::FrameSnapshot& frame);
+            //  Builds the elements of row y of the arena.
+            ftxui::Element renderRow(const core::FrameSnapshot& frame, int y);
+            //  Builds the panel of the p50, p99 and maximum duration of every profiled handler.
+            ftxui::Element renderHandlerProfile();
     };
     
 }
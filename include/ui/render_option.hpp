@@ -3,10 +3,13 @@
 
 #include <ftxui/screen/color.hpp>
 #include <ftxui/dom/elements.hpp>
+#include <ui/style_table.hpp>
 
 namespace ui {
 
-// Renderable is an object that can be drawn on the screen by FTXUI on a canvas
+// Renderable is an object that can be drawn on the screen by FTXUI on a canvas.
+// Only the glyph and the id of the style in the StyleTable are stored, so a render option is
+// cheap to copy and to compare, and drawing it reuses the decorator built for its style.
 class RenderOption {
     public:
         // Creates a new RenderOption.
@@ -18,43 +21,40 @@ class RenderOption {
             bool italic = false,
             bool underline = false,
             bool blink = false
-        ) : character(c),
-            foregroundColour(fcolour),
-            backgroundColour(bcolour),
-            bold(bold),
-            italic(italic),
-            underline(underline),
-            blink(blink) {};
+        );
 
 
         // Property getter and setter
 
-        ftxui::Color GetForeground();
+        ftxui::Color GetForeground() const;
         void SetForeground(ftxui::Color fcolour);
-        ftxui::Color GetBackground();
+        ftxui::Color GetBackground() const;
         void SetBackground(ftxui::Color bcolour);
-        bool GetBold();
+        bool GetBold() const;
         void SetBold(bool bold);
-        bool GetItalic();
+        bool GetItalic() const;
         void SetItalic(bool italic);
-        bool GetUnderline();
+        bool GetUnderline() const;
         void SetUnderline(bool underline);
-        bool GetBlink();
+        bool GetBlink() const;
         void SetBlink(bool blink);
-        char GetChar();
+        char GetChar() const;
         void SetChar(char character);
+        // Returns the id of the style in the StyleTable.
+        StyleId GetStyle() const;
 
         // Returns an FTXUI element that can be drawn on the screen.
-        ftxui::Element Render();
+        ftxui::Element Render() const;
+
+        // Returns true if both options draw the same glyph in the same style.
+        bool operator==(const RenderOption& other) const;
+        bool operator!=(const RenderOption& other) const;
 
     private:
-        ftxui::Color foregroundColour = ftxui::Color::Default;
-        ftxui::Color backgroundColour = ftxui::Color::Default;
-        bool bold = false;
-        bool italic = false;
-        bool underline = false;
-        bool blink = false;
         char character = ' ';
+        StyleId style = StyleTable::DEFAULT;
+        // Replaces the style with the given one, interning it if it changed.
+        void setStyle(const Style& newStyle);
 };
 
 }
@@ -0,0 +1,51 @@
+#ifndef UI_STYLE_TABLE_HPP
+#define UI_STYLE_TABLE_HPP
+
+#include <cstdint>
+
+#include <ftxui/dom/elements.hpp>
+#include <ftxui/screen/color.hpp>
+
+namespace ui {
+
+    //  Identifies a style interned in the StyleTable.
+    typedef std::uint16_t StyleId;
+
+    //  The look of a cell, apart from its glyph.
+    struct Style {
+        ftxui::Color Foreground = ftxui::Color::Default;
+        ftxui::Color Background = ftxui::Color::Default;
+        bool Bold = false;
+        bool Italic = false;
+        bool Underline = false;
+        bool Blink = false;
+
+        bool operator==(const Style& other) const;
+        bool operator!=(const Style& other) const;
+    };
+
+    //  The table of every distinct style used by the program, shared by all threads.
+    //  A style is interned once and referred to by its id afterwards, so two cells have the same
+    //  style exactly when they have the same id. The decorator drawing each style is built once,
+    //  when the style is interned.
+    //  Interning takes a lock; reading a style or its decorator by id does not.
+    class StyleTable {
+        public:
+            //  The maximum number of distinct styles. Styles interned beyond it fall back to DEFAULT.
+            static constexpr int CAPACITY = 1024;
+            //  The id of the default style, which is always interned.
+            static constexpr StyleId DEFAULT = 0;
+
+            //  Returns the id of the style, interning it if it is new.
+            static StyleId Intern(const Style& style);
+            //  Returns the style with the given id.
+            static const Style& Get(StyleId id);
+            //  Returns the decorator applying the style with the given id to a one-cell element.
+            static const ftxui::Decorator& GetDecorator(StyleId id);
+            //  Returns the number of styles interned.
+            static int GetSize();
+    };
+
+}
+
+#endif // UI_STYLE_TABLE_HPP
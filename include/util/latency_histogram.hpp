@@ -0,0 +1,67 @@
+#ifndef UTIL_LATENCY_HISTOGRAM_HPP
+#define UTIL_LATENCY_HISTOGRAM_HPP
+
+#include <atomic>
+#include <chrono>
+
+namespace util {
+
+    //  A histogram of durations in microseconds, in the manner of HdrHistogram: exact below 64 us,
+    //  and within 1/32 (about 3%) above, up to about 19 hours, in a fixed 8 KB of buckets.
+    //  Recording is constant time and never allocates. Only one thread may record, but any thread
+    //  may read while it does; a reader may then see a recording half counted.
+    class LatencyHistogram {
+        public:
+            //  Records a duration. Negative durations count as 0 and longer ones than the histogram
+            //  covers as the longest it does.
+            void Record(long long micros);
+            //  Returns the number of durations recorded.
+            long long GetCount() const;
+            //  Returns the mean of the durations recorded, or 0 if there is none.
+            double GetMean() const;
+            //  Returns the longest duration recorded, exactly.
+            long long GetMax() const;
+            //  Returns the duration that `percentile` percent of those recorded are at most, e.g.
+            //  GetPercentile(99) for p99, rounded up to the end of its bucket. 0 if there is none.
+            long long GetPercentile(double percentile) const;
+            //  Forgets every duration recorded. Must not be called while another thread records.
+            void Reset();
+
+        private:
+            //  The durations below 2^SUB_BUCKET_BITS us are counted one by one; above, each power of
+            //  two is split into 2^(SUB_BUCKET_BITS - 1) buckets.
+            static constexpr int SUB_BUCKET_BITS = 6;
+            static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+            static constexpr int HALF_SUB_BUCKETS = SUB_BUCKETS / 2;
+            //  The longest duration covered is just under 2^MAX_BITS us.
+            static constexpr int MAX_BITS = 36;
+            static constexpr int BUCKETS = SUB_BUCKETS + (MAX_BITS - SUB_BUCKET_BITS) * HALF_SUB_BUCKETS;
+
+            std::atomic<long long> counts[BUCKETS] = {};
+            std::atomic<long long> count{0};
+            std::atomic<long long> total{0};
+            std::atomic<long long> max{0};
+
+            //  Returns the bucket of a duration, and the longest duration in a bucket.
+            static int bucketOf(long long micros);
+            static long long highestIn(int bucket);
+    };
+
+    //  Records the time from its construction to its destruction in a histogram.
+    class LatencyTimer {
+        public:
+            explicit LatencyTimer(LatencyHistogram& histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) { }
+            ~LatencyTimer() {
+                histogram.Record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+            }
+            LatencyTimer(const LatencyTimer&) = delete;
+            LatencyTimer& operator=(const LatencyTimer&) = delete;
+
+        private:
+            LatencyHistogram& histogram;
+            std::chrono::steady_clock::time_point start;
+    };
+
+}
+
+#endif // UTIL_LATENCY_HISTOGRAM_HPP
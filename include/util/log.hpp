@@ -3,11 +3,64 @@
 
 #include <string>
 
+//  The lowest log level compiled in, as a LogLevel value. Log statements below it are removed at
+//  compile time, arguments included. Set by the build: INFO in Release builds, DEBUG otherwise.
+#ifndef UTIL_LOG_MIN_LEVEL
+#define UTIL_LOG_MIN_LEVEL 0
+#endif
+
+//  Writes a message to the log at the given level, if the level is compiled in and enabled.
+//  Unlike calling WriteToLog(), the message and the caller are not evaluated when it is not,
+//  so messages can be built freely on hot paths.
+#define UTIL_LOG(level, message, caller) \
+    do { \
+        if (static_cast<int>(level) >= UTIL_LOG_MIN_LEVEL && util::IsLogEnabled(level)) \
+            util::WriteToLog((level), (message), (caller)); \
+    } while (0)
+#define LOG_DEBUG(message, caller) UTIL_LOG(util::LogLevel::DEBUG, message, caller)
+#define LOG_INFO(message, caller) UTIL_LOG(util::LogLevel::INFO, message, caller)
+#define LOG_WARN(message, caller) UTIL_LOG(util::LogLevel::WARN, message, caller)
+#define LOG_ERROR(message, caller) UTIL_LOG(util::LogLevel::ERROR, message, caller)
+
 namespace util {
 
+    //  The severity of a log record, from the least severe.
+    enum class LogLevel {
+        DEBUG = 0, // details of what happens every tick, such as entities spawned
+        INFO = 1, // milestones and summaries, such as the game starting and its statistics
+        WARN = 2, // something unexpected the game recovered from
+        ERROR = 3, // something that failed, such as an invalid map
+        FATAL = 4, // something the game cannot continue after
+        OFF = 5, // not a level; as the threshold, disables the log
+    };
+
     //  Writes a message to the log file.
     //  Format: YYYY-MM-DD HH:MM:SS [TAG] (CALLER) MESSAGE
+    //  The record is queued and written by a background thread, so the call never waits for the
+    //  file. If the queue is full the record is dropped and counted; messages longer than a
+    //  record are cut short.
+    //  The level of the record is read from the tag; unknown tags are INFO. Records below the
+    //  runtime threshold are not written, but the message is built all the same, so prefer the
+    //  LOG_* macros on hot paths.
     void WriteToLog(const std::string& message, const std::string& caller = "?", const std::string& tag = "INFO");
+    //  Writes a message to the log file at the given level, tagged with the name of the level.
+    void WriteToLog(LogLevel level, const std::string& message, const std::string& caller = "?");
+
+    //  Sets the lowest level written to the log. Levels not compiled in stay disabled.
+    //  Defaults to DEBUG, i.e. everything compiled in is written.
+    void SetLogLevel(LogLevel level);
+    //  Returns the lowest level written to the log.
+    LogLevel GetLogLevel();
+    //  Returns true if records of the given level are written to the log.
+    bool IsLogEnabled(LogLevel level);
+    //  Returns the tag of a level, e.g. "WARN".
+    const char* GetLogLevelName(LogLevel level);
+
+    //  Blocks until every record queued before the call has been written to the log file.
+    void FlushLog();
+
+    //  Returns the number of records dropped because the queue was full.
+    long long GetDroppedLogRecords();
 
 }
-#endif // UTIL_LOG_HPP
\ No newline at end of file
+#endif // UTIL_LOG_HPP
@@ -0,0 +1,32 @@
+#ifndef UTIL_RANDOM_HPP
+#define UTIL_RANDOM_HPP
+
+#include <cstdint>
+
+namespace util {
+
+    //  A fast pseudorandom number generator (xoshiro256**) for the simulation.
+    //  The same seed always gives the same numbers, on every platform. Not thread-safe: give each
+    //  thread or subsystem a generator of its own, e.g. split off with Jump().
+    //  Not suitable for anything security related.
+    class Random {
+        public:
+            //  Constructor. The seed is expanded into the 256-bit state with splitmix64.
+            Random(std::uint64_t seed);
+            //  Returns the next 64 random bits.
+            std::uint64_t Next();
+            //  Returns a uniformly distributed integer in [0, bound). The bound must be positive.
+            int NextInt(int bound);
+            //  Returns a uniformly distributed integer in [min, max].
+            int NextInt(int min, int max);
+            //  Advances the generator by 2^128 numbers. Generators copied and jumped in turn give
+            //  sequences that never overlap in practice.
+            void Jump();
+
+        private:
+            std::uint64_t state[4];
+    };
+
+}
+
+#endif // UTIL_RANDOM_HPP
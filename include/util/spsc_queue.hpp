@@ -0,0 +1,59 @@
+#ifndef UTIL_SPSC_QUEUE_HPP
+#define UTIL_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace util {
+
+    //  A bounded lock-free queue between exactly one producer thread and one consumer thread.
+    //  The items live in a ring buffer of `Capacity` slots, which must be a power of two. Push()
+    //  is only called by the producer and Pop() only by the consumer; neither ever blocks or
+    //  allocates, so the producer can be a UI thread that must not wait on the consumer.
+    template <typename T, std::size_t Capacity>
+    class SpscQueue {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+        public:
+            //  Adds an item at the back. Returns false, and drops the item, if the queue is full.
+            //  Producer only.
+            bool Push(const T& item) {
+                std::size_t tail = this->tail.load(std::memory_order_relaxed);
+                if (tail - cachedHead == Capacity) {
+                    cachedHead = head.load(std::memory_order_acquire);
+                    if (tail - cachedHead == Capacity) return false;
+                }
+                items[tail & (Capacity - 1)] = item;
+                this->tail.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            //  Removes the item at the front into `item`. Returns false if the queue is empty.
+            //  Consumer only.
+            bool Pop(T& item) {
+                std::size_t head = this->head.load(std::memory_order_relaxed);
+                if (head == cachedTail) {
+                    cachedTail = tail.load(std::memory_order_acquire);
+                    if (head == cachedTail) return false;
+                }
+                item = items[head & (Capacity - 1)];
+                this->head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+        private:
+            //  The indices only ever grow; they are wrapped into the buffer when used. The two
+            //  sides are kept on separate cache lines, each next to its copy of the other side's
+            //  index, so that the threads do not keep invalidating each other's cache lines.
+            //  The index of the next item to pop, and the consumer's last read of `tail`.
+            alignas(64) std::atomic<std::size_t> head{0};
+            std::size_t cachedTail = 0;
+            //  The index of the next slot to push to, and the producer's last read of `head`.
+            alignas(64) std::atomic<std::size_t> tail{0};
+            std::size_t cachedHead = 0;
+            alignas(64) T items[Capacity];
+    };
+
+}
+
+#endif // UTIL_SPSC_QUEUE_HPP
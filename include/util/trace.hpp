@@ -0,0 +1,46 @@
+#ifndef UTIL_TRACE_HPP
+#define UTIL_TRACE_HPP
+
+#include <atomic>
+#include <string>
+
+namespace util {
+
+    //  Whether spans are recorded. Change it with SetTracingEnabled().
+    inline std::atomic<bool> TracingEnabled{false};
+
+    //  Starts or stops recording spans. Spans already recorded are kept until WriteTrace().
+    void SetTracingEnabled(bool enabled);
+    //  Writes the spans recorded so far to a file as a Chrome trace (JSON trace event format),
+    //  which chrome://tracing and Perfetto open, and forgets them. Returns the number of spans
+    //  written, or -1 if the file cannot be written.
+    long long WriteTrace(const std::string& path);
+    //  Returns the number of spans not recorded because the buffer of their thread was full.
+    long long GetDroppedTraceSpans();
+
+    //  Records the time from its construction to its destruction as a span of the calling thread,
+    //  if tracing is enabled when it is constructed. Costs a relaxed load of TracingEnabled when not.
+    //  Each thread records into a buffer of its own, so spans never contend with other threads.
+    class TraceSpan {
+        public:
+            //  Constructor. The name must outlive the trace, e.g. a string literal.
+            explicit TraceSpan(const char* name) : name(name) {
+                if (TracingEnabled.load(std::memory_order_relaxed)) startMicros = now();
+            }
+            ~TraceSpan() {
+                if (startMicros >= 0) record(name, startMicros);
+            }
+            TraceSpan(const TraceSpan&) = delete;
+            TraceSpan& operator=(const TraceSpan&) = delete;
+
+        private:
+            const char* name;
+            long long startMicros = -1;
+
+            static long long now();
+            static void record(const char* name, long long startMicros);
+    };
+
+}
+
+#endif // UTIL_TRACE_HPP
@@ -0,0 +1,51 @@
+#ifndef UTIL_TRIPLE_BUFFER_HPP
+#define UTIL_TRIPLE_BUFFER_HPP
+
+#include <atomic>
+
+namespace util {
+
+    //  Passes the latest version of a value from one writer thread to one reader thread without
+    //  locks. The writer fills its back buffer and publishes it; the reader takes the latest
+    //  published buffer. Publishing and taking are a single atomic exchange of the buffer in the
+    //  middle, so neither thread ever waits for the other, and neither ever sees a buffer the
+    //  other is using. Versions the reader did not take in time are skipped.
+    template <typename T>
+    class TripleBuffer {
+        public:
+            //  Returns the buffer to fill before the next Publish(). Writer only.
+            T& GetBack() {
+                return buffers[back];
+            }
+
+            //  Publishes the back buffer, and takes the previous middle buffer as the new back buffer.
+            //  Writer only.
+            void Publish() {
+                back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+            }
+
+            //  Returns the latest published buffer. It stays unchanged until the next call.
+            //  Reader only.
+            const T& GetFront() {
+                if (middle.load(std::memory_order_relaxed) & FRESH) {
+                    front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+                }
+                return buffers[front];
+            }
+
+        private:
+            //  The middle buffer is published but not yet taken by the reader.
+            static constexpr int FRESH = 4;
+            static constexpr int INDEX_MASK = 3;
+            T buffers[3];
+            //  The buffer the writer fills, and the buffer the reader reads. Each is only touched by
+            //  its own thread.
+            int back = 0;
+            int front = 1;
+            //  The buffer in between, with the FRESH flag.
+            std::atomic<int> middle{2};
+    };
+
+}
+
+#endif // UTIL_TRIPLE_BUFFER_HPP
@@ -0,0 +1,54 @@
+#ifndef UTIL_WORKER_POOL_HPP
+#define UTIL_WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+    //  A fixed set of threads that run batches of independent jobs.
+    //  The thread calling Run() works on the batch too, so a pool of N workers starts
+    //  N - 1 threads, and a pool of one worker runs everything on the caller.
+    class WorkerPool {
+        public:
+            //  Constructor. A worker count of 0 or less uses one worker per hardware thread.
+            WorkerPool(int workerCount);
+            //  Destructor. Stops and joins the threads.
+            ~WorkerPool();
+            //  Returns the number of workers, including the calling thread.
+            int GetWorkerCount() const;
+            //  Runs job(index, worker) for every index in [0, count) and returns once all are done.
+            //  `worker` is in [0, GetWorkerCount()) and identifies the worker running the job, so that
+            //  jobs can use per-worker scratch data. Jobs of a batch may run in any order.
+            void Run(int count, const std::function<void(int, int)>& job);
+
+        private:
+            int workerCount;
+            std::vector<std::thread> threads;
+            std::mutex mutex;
+            //  Signals the threads that a batch started, or that the pool is stopping.
+            std::condition_variable batchStarted;
+            //  Signals the caller that every thread is done with the batch.
+            std::condition_variable batchDone;
+            //  The current batch. Only written under the mutex while no batch is running.
+            const std::function<void(int, int)>* job = nullptr;
+            int jobCount = 0;
+            unsigned long long batch = 0;
+            bool stopping = false;
+            //  The next job to hand out, and the number of threads still working on the batch.
+            std::atomic<int> nextJob;
+            int busyThreads = 0;
+
+            //  Runs jobs of the current batch until there are none left.
+            void runJobs(int worker);
+            //  The loop of each thread.
+            void threadLoop(int worker);
+    };
+
+}
+
+#endif // UTIL_WORKER_POOL_HPP
@@ -0,0 +1,463 @@
+// The microbenchmark runner.
+// Times the core data structures and hot functions one at a time on each default map, and prints
+// one JSON object per benchmark and map on stdout (JSON Lines), so that the results of two commits
+// can be compared line by line. Run it from the directory holding res/, like the game.
+//
+// Usage: shoot_bench [--filter TEXT] [--min-time MILLIS] [--repetitions N]
+//
+// Each benchmark is repeated --repetitions times, each repetition running batches of operations
+// for at least --min-time milliseconds. The median and the fastest repetition are reported, in
+// nanoseconds per operation. Setup work between batches is not timed.
+//
+// The pathfinding.queries benchmarks answer QUERY_COUNT random start and end pairs per map with
+// each engine, and also report the nodes expanded per query and the share of queries with a path.
+// The hierarchical engine only refines the first cluster hop of its route, so its benchmarks are
+// named hierarchical_first_hop: an operation there does not produce a whole path like the others.
+
+// Standard Libraries
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Core Components
+#include <core/arena.hpp>
+#include <core/arena_reader.hpp>
+#include <core/entity.hpp>
+#include <core/game.hpp>
+#include <core/game_options.hpp>
+#include <core/leaderboard.hpp>
+#include <core/pathfinding.hpp>
+
+// UI Components
+#include <ui/render_option.hpp>
+
+// Misc headers
+#include <util/log.hpp>
+#include <util/random.hpp>
+
+// Declarations
+
+//  The default maps, by name. Each is read from res/default_maps/<name>.shoot.
+const std::vector<std::string> MAP_NAMES = {"easy", "medium", "hard"};
+//  The number of zombies placed on each map before the arena benchmarks, about as many as the
+//  hard difficulty keeps alive.
+const int BENCH_MOBS = 30;
+//  The number of random start and end pairs the pathfinding benchmarks cycle through.
+const int PATH_QUERIES = 64;
+//  The number of random start and end pairs the pathfinding.queries benchmarks answer.
+const int QUERY_COUNT = 10000;
+
+//  The options from the command line.
+struct BenchOptions {
+    std::string Filter;
+    long long MinTimeMillis = 50;
+    int Repetitions = 5;
+};
+
+//  A default map loaded into a game, with zombies placed on it.
+struct BenchArena {
+    std::string Map;
+    core::GameOptions Options;
+    core::Game* Game = nullptr;
+    core::Arena* Arena = nullptr;
+    //  The cells left empty, in a random order.
+    std::vector<core::Point> AirCells;
+};
+
+//  Keeps the results of the benchmarked calls from being optimised away.
+volatile long long benchSink = 0;
+
+//  Prints the usage to stderr and exits with code 2.
+void printUsageAndExit(const std::string& error);
+//  Parses a positive integer argument, or exits with the usage if it is not one.
+long long parsePositive(const std::string& flag, const std::string& value);
+//  Runs a benchmark and prints its result. `batch` is timed and returns the number of operations
+//  it did; `setup`, if given, runs before each batch and is not timed. `fields`, if given, returns
+//  more JSON fields for the result once the benchmark has run, e.g. counters kept by the batches.
+//  Skipped unless the name contains the filter.
+void runBenchmark(const BenchOptions& options, const std::string& name, const std::string& map,
+    const std::function<long long()>& batch, const std::function<void()>& setup = nullptr,
+    const std::function<std::string()>& fields = nullptr);
+//  Loads a default map into a game and places BENCH_MOBS zombies on it. Exits if the map is missing.
+BenchArena* loadArena(const std::string& map, util::Random& random);
+//  Deletes the game and the arena.
+void freeArena(BenchArena* bench);
+//  Runs the benchmarks on one map.
+void benchArena(const BenchOptions& options, BenchArena* bench, util::Random& random);
+//  Runs the benchmarks of one pathfinding algorithm on one map.
+void benchPathfinder(const BenchOptions& options, BenchArena* bench, const std::string& name, core::Pathfinder* pathfinder, util::Random& random);
+//  Answers QUERY_COUNT random queries with one pathfinding algorithm on one map, counting the expansions.
+void benchQueries(const BenchOptions& options, BenchArena* bench, const std::string& name, core::Pathfinder* pathfinder, util::Random& random);
+//  Runs the benchmarks of the flow fields and the cooperative planner on one map.
+void benchFlowField(const BenchOptions& options, BenchArena* bench, util::Random& random);
+//  Runs the benchmarks of the leaderboard, in a scratch directory so the real leaderboards are untouched.
+void benchLeaderboard(const BenchOptions& options, util::Random& random);
+
+int main(int argc, char** argv) {
+    // Creates runtime directories if they do not exist
+    std::filesystem::create_directories("./runtime");
+    util::WriteToLog("Benchmark process started.", "main()");
+
+    // Read the command line
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string flag = argv[i];
+        if (flag == "--help" || flag == "-h") printUsageAndExit("");
+        if (flag.rfind("--", 0) != 0 || i + 1 >= argc) printUsageAndExit("Invalid argument: " + flag);
+        std::string value = argv[++i];
+        if (flag == "--filter") options.Filter = value;
+        else if (flag == "--min-time") options.MinTimeMillis = parsePositive(flag, value);
+        else if (flag == "--repetitions") options.Repetitions = static_cast<int>(parsePositive(flag, value));
+        else printUsageAndExit("Unknown option: " + flag);
+    }
+
+    // Only warnings and errors are logged, so the log does not weigh on the timings
+    util::SetLogLevel(util::LogLevel::WARN);
+    util::Random random(1); // fixed, so every run benchmarks the same cells and paths
+
+    for (const auto& map : MAP_NAMES) {
+        auto bench = loadArena(map, random);
+        benchArena(options, bench, random);
+        freeArena(bench);
+
+        std::string path = "res/default_maps/" + map + ".shoot";
+        runBenchmark(options, "arena_reader.parse", map, [&] {
+            std::ifstream fs(path);
+            core::ArenaReader reader(fs);
+            benchSink = benchSink + reader.IsSuccess();
+            delete reader.GetArena();
+            return 1LL;
+        });
+    }
+    benchLeaderboard(options, random);
+
+    util::SetLogLevel(util::LogLevel::INFO);
+    util::WriteToLog("Benchmark process exited.", "main()");
+    return 0;
+}
+
+void printUsageAndExit(const std::string& error) {
+    if (!error.empty()) std::cerr << "shoot_bench: " << error << std::endl;
+    std::cerr << "Usage: shoot_bench [--filter TEXT] [--min-time MILLIS] [--repetitions N]" << std::endl;
+    std::exit(error.empty() ? 0 : 2);
+}
+
+long long parsePositive(const std::string& flag, const std::string& value) {
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+        printUsageAndExit("Expected a positive integer for " + flag + ", got: " + value);
+    }
+    try {
+        long long number = std::stoll(value);
+        if (number > 0) return number;
+    } catch (const std::out_of_range&) { }
+    printUsageAndExit("Expected a positive integer for " + flag + ", got: " + value);
+    return 0;
+}
+
+void runBenchmark(const BenchOptions& options, const std::string& name, const std::string& map,
+    const std::function<long long()>& batch, const std::function<void()>& setup,
+    const std::function<std::string()>& fields) {
+    if (name.find(options.Filter) == std::string::npos) return;
+
+    using Clock = std::chrono::steady_clock;
+    const auto minTime = std::chrono::milliseconds(options.MinTimeMillis);
+    std::vector<double> nanosPerOp;
+    long long operations = 0;
+    for (int repetition = 0; repetition < options.Repetitions; repetition++) {
+        Clock::duration elapsed = Clock::duration::zero();
+        operations = 0;
+        while (elapsed < minTime) {
+            if (setup) setup();
+            auto start = Clock::now();
+            operations += batch();
+            elapsed += Clock::now() - start;
+        }
+        nanosPerOp.push_back(std::chrono::duration<double, std::nano>(elapsed).count() / operations);
+    }
+    std::sort(nanosPerOp.begin(), nanosPerOp.end());
+
+    std::ostringstream json;
+    json << "{\"benchmark\": \"" << name << "\", \"map\": \"" << map << "\", "
+         << "\"repetitions\": " << options.Repetitions << ", \"operations\": " << operations << ", "
+         << "\"ns_per_op\": " << nanosPerOp[nanosPerOp.size() / 2] << ", \"min_ns_per_op\": " << nanosPerOp.front();
+    if (fields) json << ", " << fields();
+    json << "}";
+    std::cout << json.str() << std::endl;
+}
+
+BenchArena* loadArena(const std::string& map, util::Random& random) {
+    std::string path = "res/default_maps/" + map + ".shoot";
+    std::ifstream fs(path);
+    core::ArenaReader reader(fs);
+    if (!reader.IsSuccess()) {
+        std::cerr << "shoot_bench: cannot load " << path << ": " << reader.GetErrorMessage() << std::endl;
+        std::exit(1);
+    }
+
+    auto bench = new BenchArena();
+    bench->Map = map;
+    bench->Options = {
+        100,                // PlayerHp
+        reader.GetArena(),  // GameArena
+        {},                 // MobTypesGenerated
+        BENCH_MOBS,         // MaxMobs
+        0,                  // MobSpawnInterval
+        3,                  // DifficultyLevel
+    };
+    bench->Game = new core::Game(&bench->Options);
+    bench->Game->InitialiseArena();
+    bench->Arena = bench->Game->GetArena();
+    bench->Arena->SetGame(bench->Game);
+
+    for (int y = 1; y < ARENA_HEIGHT - 1; y++) {
+        for (int x = 1; x < ARENA_WIDTH - 1; x++) {
+            if (core::Entity::IsType(bench->Arena->GetPixel({x, y}), core::EntityType::AIR)) bench->AirCells.push_back({x, y});
+        }
+    }
+    for (int i = static_cast<int>(bench->AirCells.size()) - 1; i > 0; i--) {
+        std::swap(bench->AirCells[i], bench->AirCells[random.NextInt(i + 1)]);
+    }
+    for (int i = 0; i < BENCH_MOBS; i++) {
+        auto p = bench->AirCells.back();
+        bench->AirCells.pop_back();
+        bench->Arena->SetPixelWithIdSafe(p, new core::Zombie(p, bench->Arena));
+    }
+    return bench;
+}
+
+void freeArena(BenchArena* bench) {
+    bench->Game->SetTerminated(); // never ran, nothing to wait for
+    delete bench->Game; // the arena was provided, so the game does not delete it
+    delete bench->Arena;
+    delete bench;
+}
+
+void benchArena(const BenchOptions& options, BenchArena* bench, util::Random& random) {
+    auto arena = bench->Arena;
+    const auto& air = bench->AirCells;
+
+    // Lookups all over the arena, walls, air and entities alike
+    std::vector<core::Point> points;
+    for (int i = 0; i < 4096; i++) points.push_back({random.NextInt(ARENA_WIDTH), random.NextInt(ARENA_HEIGHT)});
+    runBenchmark(options, "arena.get_pixel", bench->Map, [&] {
+        long long found = 0;
+        for (auto p : points) found += arena->GetPixel(p) != nullptr;
+        benchSink = benchSink + found;
+        return static_cast<long long>(points.size());
+    });
+
+    // Empty cells turned into walls and back, the entities included
+    runBenchmark(options, "arena.set_pixel", bench->Map, [&] {
+        for (int i = 0; i < 512; i++) {
+            auto p = air[i % air.size()];
+            arena->SetPixel(p, new core::Wall(p, arena));
+            arena->SetPixel(p, new core::Air(p, arena));
+        }
+        return 1024LL;
+    });
+
+    // One zombie moved back and forth between two empty cells
+    core::Point from = air[0], to = air[1];
+    arena->SetPixelWithIdSafe(from, new core::Zombie(from, arena));
+    int movedId = arena->GetPixel(from)->Id;
+    runBenchmark(options, "arena.move", bench->Map, [&] {
+        for (int i = 0; i < 512; i++) {
+            arena->Move(from, to);
+            arena->Move(to, from);
+        }
+        return 1024LL;
+    });
+    arena->RemoveById(movedId);
+
+    // Zombies placed untimed, then removed
+    std::vector<int> ids;
+    runBenchmark(options, "arena.remove_by_id", bench->Map, [&] {
+        for (int id : ids) arena->RemoveById(id);
+        return static_cast<long long>(ids.size());
+    }, [&] {
+        ids.clear();
+        for (int i = 0; i < 256; i++) {
+            auto p = air[i % air.size()];
+            if (arena->SetPixelWithIdSafe(p, new core::Zombie(p, arena))) ids.push_back(arena->GetPixel(p)->Id);
+        }
+    });
+
+    std::vector<core::Entity*> entities = arena->GetMappedEntities();
+    const core::EntityType types[] = {
+        core::EntityType::ZOMBIE, core::EntityType::ABSTRACT_MOB, core::EntityType::ABSTRACT_COLLECTIBLE, core::EntityType::PLAYER,
+    };
+    runBenchmark(options, "entity.is_type", bench->Map, [&] {
+        long long matches = 0;
+        for (int round = 0; round < 64; round++) {
+            for (auto entity : entities) {
+                for (auto type : types) matches += core::Entity::IsType(entity, type);
+            }
+        }
+        benchSink = benchSink + matches;
+        return 64LL * static_cast<long long>(entities.size()) * 4;
+    });
+
+    runBenchmark(options, "arena.get_entities_of_type", bench->Map, [&] {
+        for (int i = 0; i < 64; i++) benchSink = benchSink + static_cast<long long>(arena->GetEntitiesOfType(core::EntityType::ABSTRACT_MOB).size());
+        return 64LL;
+    });
+
+    runBenchmark(options, "arena.get_mapped_entities", bench->Map, [&] {
+        for (int i = 0; i < 64; i++) benchSink = benchSink + static_cast<long long>(arena->GetMappedEntities().size());
+        return 64LL;
+    });
+
+    // The pathfinders used by MobMoveEventHandler::findPath, on the cells the mobs see
+    core::AStarPathfinder aStar;
+    core::JumpPointPathfinder jumpPoint;
+    core::HierarchicalPathfinder hierarchical(arena->GetClusterGraph());
+    core::DStarLitePathfinder dStarLite;
+    benchPathfinder(options, bench, "pathfinding.find_path.a_star", &aStar, random);
+    benchPathfinder(options, bench, "pathfinding.find_path.jump_point", &jumpPoint, random);
+    benchPathfinder(options, bench, "pathfinding.find_path.hierarchical_first_hop", &hierarchical, random);
+    benchPathfinder(options, bench, "pathfinding.find_path.d_star_lite", &dStarLite, random);
+
+    // Many more queries, to compare the expansions of the engines as well as their speed. D* Lite
+    // is left out: it keeps a search per mob, so unrelated queries always start it over.
+    benchQueries(options, bench, "pathfinding.queries.a_star", &aStar, random);
+    benchQueries(options, bench, "pathfinding.queries.jump_point", &jumpPoint, random);
+    benchQueries(options, bench, "pathfinding.queries.hierarchical_first_hop", &hierarchical, random);
+
+    // The default algorithm, and the field based cooperative one
+    benchFlowField(options, bench, random);
+
+    // Every cell of a frame built into an element, as the UI does for the rows that changed
+    auto frame = new core::FrameSnapshot();
+    arena->TakeFrame(*frame);
+    runBenchmark(options, "render_option.render", bench->Map, [&] {
+        for (int y = 0; y < ARENA_HEIGHT; y++) {
+            for (int x = 0; x < ARENA_WIDTH; x++) benchSink = benchSink + (frame->Cells[y][x].Render() != nullptr);
+        }
+        return static_cast<long long>(ARENA_WIDTH * ARENA_HEIGHT);
+    });
+    delete frame;
+}
+
+void benchPathfinder(const BenchOptions& options, BenchArena* bench, const std::string& name, core::Pathfinder* pathfinder, util::Random& random) {
+    auto snapshot = new core::OccupancySnapshot();
+    bench->Arena->TakeSnapshot(*snapshot);
+    std::vector<std::pair<core::Point, core::Point>> queries;
+    for (int i = 0; i < PATH_QUERIES; i++) {
+        const auto& air = bench->AirCells;
+        queries.push_back({air[random.NextInt(static_cast<int>(air.size()))], air[random.NextInt(static_cast<int>(air.size()))]});
+    }
+    runBenchmark(options, name, bench->Map, [&] {
+        for (const auto& query : queries) {
+            benchSink = benchSink + static_cast<long long>(pathfinder->FindPath(*snapshot, query.first, query.second).size());
+        }
+        return static_cast<long long>(queries.size());
+    });
+    delete snapshot;
+}
+
+void benchQueries(const BenchOptions& options, BenchArena* bench, const std::string& name, core::Pathfinder* pathfinder, util::Random& random) {
+    auto snapshot = new core::OccupancySnapshot();
+    bench->Arena->TakeSnapshot(*snapshot);
+    const auto& air = bench->AirCells;
+    std::vector<std::pair<core::Point, core::Point>> queries;
+    for (int i = 0; i < QUERY_COUNT; i++) {
+        queries.push_back({air[random.NextInt(static_cast<int>(air.size()))], air[random.NextInt(static_cast<int>(air.size()))]});
+    }
+    long long answered = 0, expansions = 0, found = 0;
+    runBenchmark(options, name, bench->Map, [&] {
+        for (const auto& query : queries) {
+            found += !pathfinder->FindPath(*snapshot, query.first, query.second).empty();
+            expansions += pathfinder->GetLastExpansions();
+        }
+        answered += static_cast<long long>(queries.size());
+        return static_cast<long long>(queries.size());
+    }, nullptr, [&] {
+        std::ostringstream fields;
+        fields << "\"queries\": " << QUERY_COUNT << ", \"expansions_per_query\": " << static_cast<double>(expansions) / answered
+               << ", \"found_ratio\": " << static_cast<double>(found) / answered;
+        return fields.str();
+    });
+    delete snapshot;
+}
+
+void benchFlowField(const BenchOptions& options, BenchArena* bench, util::Random& random) {
+    auto snapshot = new core::OccupancySnapshot();
+    bench->Arena->TakeSnapshot(*snapshot);
+    const auto& air = bench->AirCells;
+    std::vector<core::Point> cells;
+    for (int i = 0; i < PATH_QUERIES; i++) cells.push_back(air[random.NextInt(static_cast<int>(air.size()))]);
+    auto field = new core::FlowField();
+
+    // The field recomputed from the player, as on every tick the player has moved
+    runBenchmark(options, "pathfinding.flow_field.compute", bench->Map, [&] {
+        for (auto p : cells) field->Compute(*snapshot, {p});
+        benchSink = benchSink + field->GetDistance(cells.front());
+        return static_cast<long long>(cells.size());
+    });
+
+    // The step of every mob read from a computed field
+    core::Point target = cells.front();
+    field->Compute(*snapshot, {target});
+    runBenchmark(options, "pathfinding.flow_field.next_step", bench->Map, [&] {
+        long long moved = 0;
+        for (int round = 0; round < 64; round++) {
+            for (auto p : cells) moved += field->NextStep(p, *snapshot) != p;
+        }
+        benchSink = benchSink + moved;
+        return 64LL * static_cast<long long>(cells.size());
+    });
+
+    // A wave of mobs planned one after another against the reservations of those before
+    auto mobs = bench->Arena->GetEntitiesOfType(core::EntityType::ABSTRACT_MOB);
+    int ticksPerMove = mobs.empty() ? 1 : static_cast<core::AbstractMob*>(mobs.front())->GetTicksPerMove();
+    core::CooperativePlanner planner;
+    core::ReservationTable* reservations = nullptr;
+    runBenchmark(options, "pathfinding.cooperative.plan_path", bench->Map, [&] {
+        for (int i = 0; i < static_cast<int>(cells.size()); i++) {
+            benchSink = benchSink + static_cast<long long>(planner.PlanPath(*snapshot, *field, *reservations,
+                i + 1, cells[i], target, 0, 1, ticksPerMove).size());
+        }
+        return static_cast<long long>(cells.size());
+    }, [&] {
+        delete reservations;
+        reservations = new core::ReservationTable();
+    });
+    delete reservations;
+    delete field;
+    delete snapshot;
+}
+
+void benchLeaderboard(const BenchOptions& options, util::Random& random) {
+    if (std::string("leaderboard.add_entry").find(options.Filter) == std::string::npos) return;
+
+    // The leaderboard reads and writes ./runtime/leaderboard_*.txt, so run it elsewhere
+    auto workingDirectory = std::filesystem::current_path();
+    auto scratchDirectory = std::filesystem::temp_directory_path() / "shoot_bench";
+    std::filesystem::remove_all(scratchDirectory);
+    std::filesystem::create_directories(scratchDirectory / "runtime");
+    std::filesystem::current_path(scratchDirectory);
+
+    // Entries inserted into a leaderboard of 1000, kept at that size by refilling it untimed
+    core::Leaderboard* leaderboard = nullptr;
+    runBenchmark(options, "leaderboard.add_entry", "-", [&] {
+        for (int i = 0; i < 100; i++) leaderboard->AddEntry("bench", 1700000000 + i, random.NextInt(10000));
+        return 100LL;
+    }, [&] {
+        delete leaderboard;
+        std::filesystem::remove(scratchDirectory / "runtime" / "leaderboard_custom.txt");
+        leaderboard = new core::Leaderboard(3);
+        for (int i = 0; i < 1000; i++) leaderboard->AddEntry("bench", 1700000000 + i, random.NextInt(10000));
+    });
+    delete leaderboard;
+
+    std::filesystem::current_path(workingDirectory);
+    std::filesystem::remove_all(scratchDirectory);
+}
@@ -1,5 +1,6 @@
 #include <core/arena.hpp>
 #include <core/entity.hpp>
+#include <core/pathfinding.hpp>
 
 #include <util/log.hpp>
 
@@ -7,14 +8,16 @@ namespace core {
 
     Arena::Arena() {
         util::WriteToLog("Constructing Arena with default map...", "Arena::Arena()");
+        air = new Air({0, 0}, this);
+        wall = new Wall({0, 0}, this);
         for (int i = 0; i < ARENA_HEIGHT; i++) {
             for (int j = 0; j < ARENA_WIDTH; j++) {
                 if (i == 0 || i == ARENA_HEIGHT - 1 || j == 0 || j == ARENA_WIDTH - 1) {
                     // The outermost layer of the arena is always walls
-                    pixel[i][j] = new Wall({i, j}, this);
+                    cells[i][j] = {EntityType::WALL, -1};
                 } else {
                     // Initialize the inner pixels with air
-                    pixel[i][j] = new Air({i, j}, this);
+                    cells[i][j] = {EntityType::AIR, -1};
                 }
             }
         }
@@ -23,18 +26,18 @@ namespace core {
 
     Arena::~Arena() {
         util::WriteToLog("Arena destructor called.", "Arena::~Arena()");
-        for (int i = 0; i < ARENA_HEIGHT; i++) {
-            for (int j = 0; j < ARENA_WIDTH; j++) {
-                delete pixel[i][j];
-                pixel[i][j] = nullptr;
-            }
-        }
+        for (auto entity : entityTable) delete entity;
+        entityTable.clear();
+        freeSlots.clear();
+        delete air;
+        delete wall;
+        delete clusterGraph;
         util::WriteToLog("Arena destructor completed.", "Arena::~Arena()");
     }
 
     Entity* Arena::GetPixel(Point p) {
         std::lock_guard<std::mutex> lock(arenaMutex);
-        return pixel[p.y][p.x];
+        return entityAt(p);
     }
 
     void Arena::SetPixel(Point p, Entity* entity) {
@@ -43,9 +46,17 @@ namespace core {
             // Do not allow setting pixels on the outermost layer
             return;
         }
-        delete pixel[p.y][p.x];
-        pixel[p.y][p.x] = entity;
-        entity->SetPosition(p);
+        placeEntity(p, entity);
+    }
+
+    void Arena::SetBlock(Point p, EntityType type) {
+        std::lock_guard<std::mutex> lock(arenaMutex);
+        if (p.x == 0 || p.x == ARENA_WIDTH - 1 || p.y == 0 || p.y == ARENA_HEIGHT - 1) {
+            // Do not allow setting pixels on the outermost layer
+            return;
+        }
+        clearCell(p);
+        if (type == EntityType::WALL) cells[p.y][p.x].Type = EntityType::WALL;
     }
 
     bool Arena::SetPixelSafe(Point p, Entity* entity) {
@@ -54,10 +65,8 @@ namespace core {
             // Do not allow setting pixels on the outermost layer
             return false;
         }
-        if (Entity::IsType(pixel[p.y][p.x], EntityType::AIR)) {
-            delete pixel[p.y][p.x];
-            pixel[p.y][p.x] = entity;
-            entity->SetPosition(p);
+        if (cells[p.y][p.x].Type == EntityType::AIR) {
+            placeEntity(p, entity);
             return true;
         }
         return false;
@@ -65,38 +74,34 @@ namespace core {
 
     void Arena::SetPixelWithId(Point p, Entity* entity) {
         std::lock_guard<std::mutex> lock(arenaMutex);
-        util::WriteToLog("Attempting to set pixel and assign an ID at (" + std::to_string(p.x) + ", " + std::to_string(p.y) + ")...", "Arena::SetPixelWithId()");
+        LOG_DEBUG("Attempting to set pixel and assign an ID at (" + std::to_string(p.x) + ", " + std::to_string(p.y) + ")...", "Arena::SetPixelWithId()");
         if (p.x == 0 || p.x == ARENA_WIDTH - 1 || p.y == 0 || p.y == ARENA_HEIGHT - 1) {
             // Do not allow setting pixels on the outermost layer
             return;
         }
-        delete pixel[p.y][p.x];
-        pixel[p.y][p.x] = entity;
-        util::WriteToLog("Entity at (" + std::to_string(p.x) + ", " + std::to_string(p.y) + ") assigned ID: " + std::to_string(idIncr), "Arena::SetPixelWithId()");
+        placeEntity(p, entity);
+        LOG_DEBUG("Entity at (" + std::to_string(p.x) + ", " + std::to_string(p.y) + ") assigned ID: " + std::to_string(idIncr), "Arena::SetPixelWithId()");
         entityIndex[idIncr] = entity;
         entity->Id = idIncr;
         idIncr++;
-        entity->SetPosition(p);
     }
 
     bool Arena::SetPixelWithIdSafe(Point p, Entity* entity) {
         std::lock_guard<std::mutex> lock(arenaMutex);
-        util::WriteToLog("Attempting to set pixel safely and assign an ID at (" + std::to_string(p.x) + ", " + std::to_string(p.y) + ")...", "Arena::SetPixelWithIdSafe()");
+        LOG_DEBUG("Attempting to set pixel safely and assign an ID at (" + std::to_string(p.x) + ", " + std::to_string(p.y) + ")...", "Arena::SetPixelWithIdSafe()");
         if (p.x == 0 || p.x == ARENA_WIDTH - 1 || p.y == 0 || p.y == ARENA_HEIGHT - 1) {
             // Do not allow setting pixels on the outermost layer
             return false;
         }
-        if (Entity::IsType(pixel[p.y][p.x], EntityType::AIR)) {
-            delete pixel[p.y][p.x];
-            pixel[p.y][p.x] = entity;
-            util::WriteToLog("Entity at (" + std::to_string(p.x) + ", " + std::to_string(p.y) + ") assigned ID: " + std::to_string(idIncr), "Arena::SetPixelWithIdSafe()");
+        if (cells[p.y][p.x].Type == EntityType::AIR) {
+            placeEntity(p, entity);
+            LOG_DEBUG("Entity at (" + std::to_string(p.x) + ", " + std::to_string(p.y) + ") assigned ID: " + std::to_string(idIncr), "Arena::SetPixelWithIdSafe()");
             entityIndex[idIncr] = entity;
             entity->Id = idIncr;
             idIncr++;
-            entity->SetPosition(p);
             return true;
         }
-        util::WriteToLog("Failed to set pixel at (" + std::to_string(p.x) + ", " + std::to_string(p.y) + ").", "Arena::SetPixelWithIdSafe()");
+        LOG_DEBUG("Failed to set pixel at (" + std::to_string(p.x) + ", " + std::to_string(p.y) + ").", "Arena::SetPixelWithIdSafe()");
         return false;
     }
 
@@ -122,13 +127,7 @@ namespace core {
 
     void Arena::Replace(Point p, Entity* entity) {
         std::lock_guard<std::mutex> lock(arenaMutex);
-        try {
-            delete pixel[p.y][p.x];
-        } catch(const std::exception& _) {
-            ; // do nothing
-        }
-        pixel[p.y][p.x] = entity;
-        entity->SetPosition(p);
+        placeEntity(p, entity);
     }
 
     void Arena::ReplaceWithId(int id, Entity* entity) {
@@ -136,9 +135,7 @@ namespace core {
         auto it = entityIndex.find(id);
         if (it != entityIndex.end()) {
             Point p = it->second->GetPosition();
-            delete pixel[p.y][p.x];
-            pixel[p.y][p.x] = entity;
-            entity->SetPosition(p);
+            placeEntity(p, entity);
             entity->Id = id;
             entityIndex.erase(it);
             entityIndex[id] = entity;
@@ -147,27 +144,25 @@ namespace core {
 
     void Arena::Remove(Point p) {
         std::lock_guard<std::mutex> lock(arenaMutex);
-        delete pixel[p.y][p.x];
-        pixel[p.y][p.x] = new Air({p.x, p.y}, this);
+        clearCell(p);
     }
 
     void Arena::RemoveById(int id) {
         std::lock_guard<std::mutex> lock(arenaMutex);
         auto it = entityIndex.find(id);
         if (it != entityIndex.end()) {
-            Point p = it->second->GetPosition();
-            delete pixel[p.y][p.x];
-            pixel[p.y][p.x] = new Air({p.x, p.y}, this);
+            clearCell(it->second->GetPosition());
             entityIndex.erase(it);
         }
     }
 
     void Arena::Move(Point start, Point dest) {
         std::lock_guard<std::mutex> lock(arenaMutex);
-        delete pixel[dest.y][dest.x];
-        pixel[dest.y][dest.x] = pixel[start.y][start.x];
-        pixel[start.y][start.x] = new Air({start.x, start.y}, this);
-        pixel[dest.y][dest.x]->SetPosition(dest);
+        clearCell(dest);
+        cells[dest.y][dest.x] = cells[start.y][start.x];
+        cells[start.y][start.x] = {EntityType::AIR, -1};
+        occupancyRowVersions[start.y] = ++occupancyVersion;
+        entityAt(dest)->SetPosition(dest);
     }
 
     std::vector<Entity*> Arena::GetMappedEntities() {
@@ -184,12 +179,102 @@ namespace core {
         std::list<Entity*> entities;
         for (int y = 0; y < ARENA_HEIGHT; y++) {
             for (int x = 0; x < ARENA_WIDTH; x++) {
-                if (Entity::IsType(pixel[y][x], type)) {
-                    entities.push_back(pixel[y][x]);
+                if (TypeAncestry(cells[y][x].Type) & TypeBit(type)) {
+                    entities.push_back(entityAt({x, y}));
                 }
             }
         }
         return entities;
     }
 
+    void Arena::TakeSnapshot(OccupancySnapshot& snapshot) {
+        std::lock_guard<std::mutex> lock(arenaMutex);
+        for (int y = 0; y < ARENA_HEIGHT; y++) {
+            for (int x = 0; x < ARENA_WIDTH; x++) {
+                snapshot.Types[y][x] = cells[y][x].Type;
+            }
+            snapshot.RowVersion[y] = occupancyRowVersions[y];
+        }
+    }
+
+    bool Arena::TakeFrame(FrameSnapshot& frame) {
+        auto airOption = air->GetRenderOption();
+        auto wallOption = wall->GetRenderOption();
+        std::lock_guard<std::mutex> lock(arenaMutex);
+        frameCount++;
+        bool changed = false;
+        for (int y = 0; y < ARENA_HEIGHT; y++) {
+            bool rowChanged = false;
+            for (int x = 0; x < ARENA_WIDTH; x++) {
+                const Cell& cell = cells[y][x];
+                if (cell.Slot >= 0) frame.Cells[y][x] = entityTable[cell.Slot]->GetRenderOption();
+                else frame.Cells[y][x] = cell.Type == EntityType::WALL ? wallOption : airOption;
+                frame.Collectible[y][x] = (TypeAncestry(cell.Type) & TypeBit(EntityType::ABSTRACT_COLLECTIBLE)) != 0;
+                if (frame.Cells[y][x] != frameCells[y][x]) {
+                    frameCells[y][x] = frame.Cells[y][x];
+                    rowChanged = true;
+                }
+            }
+            if (rowChanged) frameRowVersions[y] = frameCount;
+            frame.RowVersion[y] = frameRowVersions[y];
+            changed = changed || rowChanged;
+        }
+        return changed;
+    }
+
+    void Arena::BuildClusterGraph() {
+        OccupancySnapshot snapshot;
+        TakeSnapshot(snapshot);
+        auto graph = new ClusterGraph(snapshot);
+        {
+            std::lock_guard<std::mutex> lock(arenaMutex);
+            delete clusterGraph;
+            clusterGraph = graph;
+        }
+        util::WriteToLog("Cluster graph built with " + std::to_string(graph->GetNodeCount()) + " nodes.", "Arena::BuildClusterGraph()");
+    }
+
+    const ClusterGraph* Arena::GetClusterGraph() {
+        std::lock_guard<std::mutex> lock(arenaMutex);
+        return clusterGraph;
+    }
+
+    Entity* Arena::entityAt(Point p) {
+        const Cell& cell = cells[p.y][p.x];
+        if (cell.Slot >= 0) return entityTable[cell.Slot];
+        return cell.Type == EntityType::WALL ? static_cast<Entity*>(wall) : static_cast<Entity*>(air);
+    }
+
+    void Arena::clearCell(Point p) {
+        Cell& cell = cells[p.y][p.x];
+        if (cell.Slot >= 0) {
+            delete entityTable[cell.Slot];
+            entityTable[cell.Slot] = nullptr;
+            freeSlots.push_back(cell.Slot);
+        }
+        cell = {EntityType::AIR, -1};
+        occupancyRowVersions[p.y] = ++occupancyVersion;
+    }
+
+    void Arena::placeEntity(Point p, Entity* entity) {
+        clearCell(p);
+        if (Entity::IsType(entity, EntityType::ABSTRACT_BLOCK)) {
+            //  Blocks are never kept as objects in the grid.
+            cells[p.y][p.x].Type = entity->GetType();
+            if (entity != air && entity != wall) delete entity;
+            return;
+        }
+        int slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+            entityTable[slot] = entity;
+        } else {
+            slot = static_cast<int>(entityTable.size());
+            entityTable.push_back(entity);
+        }
+        cells[p.y][p.x] = {entity->GetType(), slot};
+        entity->SetPosition(p);
+    }
+
 }
@@ -36,23 +36,23 @@ namespace core {
             if (!std::getline(*file, line)) line = std::string(ARENA_WIDTH, ' ');
             if (line.length() < ARENA_WIDTH) line.append(ARENA_WIDTH - line.length(), ' ');
             if (line.length() > ARENA_WIDTH) line = line.substr(0, ARENA_WIDTH);
-            util::WriteToLog("Parsing line " + std::to_string(y) + ": " + line, "ArenaReader::parseFile_()");
+            LOG_DEBUG("Parsing line " + std::to_string(y) + ": " + line, "ArenaReader::parseFile_()");
             for (int x = 0; x < ARENA_WIDTH; ++x) {
                 char c = line[x];
                 switch (c) {
                     case 'X': // wall
-                        arena->SetPixel({x, y}, new Wall({x, y}, arena));
+                        arena->SetBlock({x, y}, EntityType::WALL);
                         break;
                     case 'P': // player
                         if (!playerFound) {
-                            util::WriteToLog("Player found at (" + std::to_string(x) + ", " + std::to_string(y) + ")", "ArenaReader::parseFile_()");
+                            LOG_DEBUG("Player found at (" + std::to_string(x) + ", " + std::to_string(y) + ")", "ArenaReader::parseFile_()");
                             // check if player is on the edge
                             if (x == 0 || x == ARENA_WIDTH - 1 || y == 0 || y == ARENA_HEIGHT - 1) {
                                 util::WriteToLog("Player is on the edge of the arena. Invalid position.", "ArenaReader::parseFile_()", "ERROR");
                                 errmsg = "Invalid player position. Player cannot be on the edge of the arena.";
                                 return false;
                             }
-                            static Player* player = new Player({x, y}, arena, 0);
+                            auto player = new Player({x, y}, arena, 0);
                             arena->SetPixelWithId({x, y}, player); // player HP will be set in InitialiseEventHandler
                             playerFound = true;
                             break;
@@ -61,7 +61,7 @@ namespace core {
                         errmsg = "Invalid file syntax. More than one \'P\' found in the file. (line " + std::to_string(y) + ", column " + std::to_string(x) + ")";
                         return false;
                     case ' ': // air
-                        arena->SetPixel({x, y}, new Air({x, y}, arena));
+                        arena->SetBlock({x, y}, EntityType::AIR);
                         break;
                     default:
                         util::WriteToLog("Invalid file syntax. Unknown character \'" + std::string(1, c) + "\' found in the file.", "ArenaReader::parseFile_()", "ERROR");
@@ -78,6 +78,7 @@ namespace core {
         }
 
         util::WriteToLog("Arena file parsed successfully.", "ArenaReader::parseFile_()");
+        arena->BuildClusterGraph(); // walls are final from here on
         return true;
     }
 
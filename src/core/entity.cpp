@@ -80,7 +80,8 @@ namespace core {
 
     //  BEGIN: Entity
 
-    Entity::Entity(Point position, Arena* arena) : position(position), arena(arena) {}
+    Entity::Entity(Point position, Arena* arena, EntityType type)
+        : position(position), arena(arena), type(type), typeMask(TypeAncestry(type)) {}
 
     Point Entity::GetPosition() {
         return position;
@@ -90,44 +91,8 @@ namespace core {
         this->position = position;
     }
 
-    bool Entity::IsType(Entity* entity, EntityType type) {
-        if (entity == nullptr) return false;
-        switch (type) {
-            case EntityType::ABSTRACT_ENTITY:
-                return true;
-            case EntityType::ABSTRACT_BLOCK:
-                return dynamic_cast<AbstractBlock*>(entity) != nullptr;
-            case EntityType::ABSTRACT_MOB:
-                return dynamic_cast<AbstractMob*>(entity) != nullptr;
-            case EntityType::PLAYER_BULLET:
-                return dynamic_cast<PlayerBullet*>(entity) != nullptr;
-            case EntityType::ABSTRACT_COLLECTIBLE:
-                return dynamic_cast<AbstractCollectible*>(entity) != nullptr;
-            case EntityType::WALL:
-                return dynamic_cast<Wall*>(entity) != nullptr;
-            case EntityType::AIR:
-                return dynamic_cast<Air*>(entity) != nullptr;
-            case EntityType::PLAYER:
-                return dynamic_cast<Player*>(entity) != nullptr;
-            case EntityType::ZOMBIE:
-                return dynamic_cast<Zombie*>(entity) != nullptr;
-            case EntityType::TROLL:
-                return dynamic_cast<Troll*>(entity) != nullptr;
-            case EntityType::BABY_ZOMBIE:
-                return dynamic_cast<BabyZombie*>(entity) != nullptr;
-            case EntityType::MONSTER:
-                return dynamic_cast<Monster*>(entity) != nullptr;
-            case EntityType::BOSS:
-                return dynamic_cast<Boss*>(entity) != nullptr;
-            case EntityType::ENERGY_DRINK:
-                return dynamic_cast<EnergyDrink*>(entity) != nullptr;
-            case EntityType::STRENGTH_POTION:
-                return dynamic_cast<StrengthPotion*>(entity) != nullptr;
-            case EntityType::SHIELD:
-                return dynamic_cast<Shield*>(entity) != nullptr;
-            default:
-                return false;
-        }
+    EntityType Entity::GetType() const {
+        return type;
     }
 
     ui::RenderOption Entity::GetRenderOption() {
@@ -140,7 +105,7 @@ namespace core {
 
     //  BEGIN: AbstractBlock
 
-    AbstractBlock::AbstractBlock(Point position, Arena* arena) : Entity(position, arena) {}
+    AbstractBlock::AbstractBlock(Point position, Arena* arena, EntityType type) : Entity(position, arena, type) {}
 
     bool AbstractBlock::Move(Point to) {
         //  Blocks cannot move.
@@ -151,8 +116,8 @@ namespace core {
 
     //  BEGIN: AbstractMob
 
-    AbstractMob::AbstractMob(Point position, Arena* arena, int hp, int damage, int killScore, int ticksPerMove)
-        : Entity(position, arena), hp(hp), damage(damage), killScore(killScore), ticksPerMove(ticksPerMove) {
+    AbstractMob::AbstractMob(Point position, Arena* arena, EntityType type, int hp, int damage, int killScore, int ticksPerMove)
+        : Entity(position, arena, type), hp(hp), damage(damage), killScore(killScore), ticksPerMove(ticksPerMove) {
             lastMoveTick = arena->GetGame()->GetGameClock();
         }
 
@@ -165,7 +130,8 @@ namespace core {
         }
         if (hp <= 1) renderOption.SetItalic(true); //  Set to italic when HP is low
         if (hp > 1) renderOption.SetItalic(false);
-        // mob removal logic implemented in the event handler
+        // mob removal logic implemented in the event handler, wake the mob up so it runs now
+        if (hp <= 0) arena->GetGame()->GetScheduler()->WakeUp(this);
     }
 
     void AbstractMob::ChangeDamage(int delta) {
@@ -182,10 +148,15 @@ namespace core {
             return false; // Not enough time has passed
         }
 
+        if (to == GetPosition()) { // planned wait, e.g. to let another mob pass first
+            lastMoveTick = currentTime;
+            return true;
+        }
+
         Entity* target = arena->GetPixel(to);
 
         if (IsType(target, EntityType::PLAYER)) { // collides with player
-            dynamic_cast<Player*>(target)->TakeDamage(damage);
+            static_cast<Player*>(target)->TakeDamage(damage);
             lastMoveTick = currentTime;
             return false; // Mob does not disappear after attack, it will stay and attack again until killed.
         }
@@ -193,7 +164,7 @@ namespace core {
         // collision with bullet will be handled in the bullet class
 
         if (IsType(target, EntityType::ABSTRACT_COLLECTIBLE)) { // collides with wall
-            dynamic_cast<AbstractCollectible*>(target)->PickUp(this);
+            static_cast<AbstractCollectible*>(target)->PickUp(this);
             lastMoveTick = currentTime;
             return false;
         }
@@ -227,11 +198,24 @@ namespace core {
         renderOption.SetUnderline(true);
     }
 
+    int AbstractMob::GetTicksPerMove() const { return ticksPerMove; }
+
+    long long AbstractMob::GetNextMoveTick() const { return lastMoveTick + ticksPerMove; }
+
+    long long AbstractMob::GetNextWakeupTick() const {
+        long long nextTick = GetNextMoveTick();
+        long long currentTime = arena->GetGame()->GetGameClock();
+        if (shieldExpireTick >= currentTime && shieldExpireTick + 1 < nextTick) {
+            nextTick = shieldExpireTick + 1; // the first tick the shield is off
+        }
+        return nextTick;
+    }
+
     //  END: AbstractMob
 
     //  BEGIN: AbstractCollectible
 
-    AbstractCollectible::AbstractCollectible(Point position, Arena* arena, int lifetime) : Entity(position, arena), lifetime(lifetime) {
+    AbstractCollectible::AbstractCollectible(Point position, Arena* arena, EntityType type, int lifetime) : Entity(position, arena, type), lifetime(lifetime) {
         spawnTick = arena->GetGame()->GetGameClock();
     }
 
@@ -252,6 +236,18 @@ namespace core {
         return false; // still valid
     }
 
+    long long AbstractCollectible::GetNextWakeupTick() const {
+        long long currentTime = arena->GetGame()->GetGameClock();
+        long long blinkTick = spawnTick + lifetime - 50 * 3; // see RefreshStatus()
+        if (currentTime < blinkTick) return blinkTick;
+        return spawnTick + lifetime + 1; // the first tick IsInvalid() returns true
+    }
+
+    void AbstractCollectible::markPickedUp() {
+        pickedUp = true;
+        arena->GetGame()->GetScheduler()->WakeUp(this);
+    }
+
     bool AbstractCollectible::Move(Point p) {
         //  Collectibles cannot move.
         return false;
@@ -262,7 +258,7 @@ namespace core {
     //  BEGIN: PlayerBullet
 
     PlayerBullet::PlayerBullet(Point position, Arena* arena, int damage, int direction)
-        : Entity(position, arena), damage(damage), direction(direction), bulletSpawnTick(arena->GetGame()->GetGameClock()) { 
+        : Entity(position, arena, TypeId), damage(damage), direction(direction), bulletSpawnTick(arena->GetGame()->GetGameClock()) { 
         renderOption = EntityRenderOptions::PlayerBulletRenderOption();
     }
 
@@ -304,19 +300,19 @@ namespace core {
         }
 
         if (IsType(target, EntityType::PLAYER)) {
-            dynamic_cast<Player*>(target)->TakeDamage(damage);
+            static_cast<Player*>(target)->TakeDamage(damage);
             exploded = true;
             return false;
         }
 
         if (IsType(target, EntityType::ABSTRACT_MOB)) {
-            dynamic_cast<AbstractMob*>(target)->TakeDamage(damage);
+            static_cast<AbstractMob*>(target)->TakeDamage(damage);
             exploded = true;
             return false;
         }
 
         if (IsType(target, EntityType::ABSTRACT_COLLECTIBLE)) {
-            dynamic_cast<AbstractCollectible*>(target)->PickUp(this);
+            static_cast<AbstractCollectible*>(target)->PickUp(this);
             exploded = true;
             return false;
         }
@@ -346,13 +342,13 @@ namespace core {
         Entity* target = arena->GetPixel(targetPoint);
 
         if (IsType(target, EntityType::ABSTRACT_MOB)) {
-            dynamic_cast<AbstractMob*>(target)->TakeDamage(damage);
+            static_cast<AbstractMob*>(target)->TakeDamage(damage);
             exploded = true; // Bullet explodes on mob
             return false; // Bullet should be removed and never placed in the arena
         }
 
         if (IsType(target, EntityType::PLAYER)) {
-            dynamic_cast<Player*>(target)->TakeDamage(damage);
+            static_cast<Player*>(target)->TakeDamage(damage);
             exploded = true; // Bullet explodes on player
             return false;
         }
@@ -364,7 +360,7 @@ namespace core {
 
         if (IsType(target, EntityType::ABSTRACT_COLLECTIBLE)) {
             //  The bullet will shatter the collectible, as if it was picked up
-            dynamic_cast<AbstractCollectible*>(target)->PickUp(this);
+            static_cast<AbstractCollectible*>(target)->PickUp(this);
             exploded = true; // Bullet explodes on collectible
             return false;
         }
@@ -422,7 +418,7 @@ namespace core {
 
     //  BEGIN: Wall
 
-    Wall::Wall(Point position, Arena* arena) : AbstractBlock(position, arena) {
+    Wall::Wall(Point position, Arena* arena) : AbstractBlock(position, arena, TypeId) {
         renderOption = EntityRenderOptions::WallRenderOption();
     }
 
@@ -430,7 +426,7 @@ namespace core {
 
     //  BEGIN: Air
 
-    Air::Air(Point position, Arena* arena) : AbstractBlock(position, arena) {
+    Air::Air(Point position, Arena* arena) : AbstractBlock(position, arena, TypeId) {
         renderOption = EntityRenderOptions::AirRenderOption();
     }
 
@@ -438,7 +434,7 @@ namespace core {
 
     //  BEGIN: Player
 
-    Player::Player(Point position, Arena* arena, int initialHp) : Entity(position, arena), hp(initialHp) {
+    Player::Player(Point position, Arena* arena, int initialHp) : Entity(position, arena, TypeId), hp(initialHp) {
         renderOption = EntityRenderOptions::PlayerRenderOption();
         damage = 1;
     }
@@ -449,7 +445,7 @@ namespace core {
             renderOption.SetUnderline(false);
         }
         if (hp <= 0) {
-            ui::appScreen.ExitLoopClosure()();
+            if (!arena->GetGame()->IsHeadless()) ui::appScreen.ExitLoopClosure()();
             arena->GetGame()->Terminate();
         }
     }
@@ -474,7 +470,7 @@ namespace core {
         }
 
         if (IsType(target, EntityType::ABSTRACT_COLLECTIBLE)) {
-            dynamic_cast<AbstractCollectible*>(target)->PickUp(this);
+            static_cast<AbstractCollectible*>(target)->PickUp(this);
             return false;
         }
 
@@ -501,7 +497,7 @@ namespace core {
 
     Zombie::Zombie(Point position, Arena* arena) 
         : AbstractMob(
-            position, arena,
+            position, arena, TypeId,
             1, 1, 1, 50 // HP, damage, killScore, ticksPerMove
         ) {
         renderOption = EntityRenderOptions::ZombieRenderOption();
@@ -513,7 +509,7 @@ namespace core {
 
     Troll::Troll(Point position, Arena* arena)
         : AbstractMob(
-            position, arena, 
+            position, arena, TypeId,
             5, 2, 5, 100 // HP, damage, killScore, ticksPerMove
         ) {
         renderOption = EntityRenderOptions::TrollRenderOption();
@@ -525,7 +521,7 @@ namespace core {
 
     BabyZombie::BabyZombie(Point position, Arena* arena)
         : AbstractMob(
-            position, arena,
+            position, arena, TypeId,
             1, 1, 2, 25 // HP, damage, killScore, ticksPerMove
         ) {
         renderOption = EntityRenderOptions::BabyZombieRenderOption();
@@ -537,7 +533,7 @@ namespace core {
 
     Monster::Monster(Point position, Arena* arena)
         : AbstractMob(
-            position, arena,
+            position, arena, TypeId,
             10, 5, 10, 25 // HP, damage, killScore, ticksPerMove
         ) {
         renderOption = EntityRenderOptions::MonsterRenderOption();
@@ -549,7 +545,7 @@ namespace core {
 
     Boss::Boss(Point position, Arena* arena)
         : AbstractMob(
-            position, arena,
+            position, arena, TypeId,
             1000, 50, 100, 200 // HP, damage, killScore, ticksPerMove
         ) {
         renderOption = EntityRenderOptions::BossRenderOption();
@@ -559,25 +555,25 @@ namespace core {
 
     //  BEGIN: EnergyDrink
 
-    EnergyDrink::EnergyDrink(Point position, Arena* arena, int healingPoint) : AbstractCollectible(position, arena, 50 * 10), hp(healingPoint) {
+    EnergyDrink::EnergyDrink(Point position, Arena* arena, int healingPoint) : AbstractCollectible(position, arena, TypeId, 50 * 10), hp(healingPoint) {
         renderOption = EntityRenderOptions::EnergyDrinkRenderOption(healingPoint);
     }
 
     bool EnergyDrink::PickUp(Entity* by) {
         if (IsType(by, EntityType::PLAYER)) {
-            dynamic_cast<Player*>(by)->TakeDamage(-hp);
-            pickedUp = true;
+            static_cast<Player*>(by)->TakeDamage(-hp);
+            markPickedUp();
             return true;
         }
 
         if (IsType(by, EntityType::ABSTRACT_MOB)) {
-            dynamic_cast<AbstractMob*>(by)->TakeDamage(-hp);
-            pickedUp = true;
+            static_cast<AbstractMob*>(by)->TakeDamage(-hp);
+            markPickedUp();
             return true;
         }
 
         if (IsType(by, EntityType::PLAYER_BULLET)) {
-            pickedUp = true; // bullet will shatter the energy drink, as if it was picked up
+            markPickedUp(); // bullet will shatter the energy drink, as if it was picked up
             return true;
         }
 
@@ -588,25 +584,25 @@ namespace core {
 
     //  BEGIN: StrengthPotion
 
-    StrengthPotion::StrengthPotion(Point position, Arena* arena, int damage) : AbstractCollectible(position, arena, 50 * 10), damage(damage) {
+    StrengthPotion::StrengthPotion(Point position, Arena* arena, int damage) : AbstractCollectible(position, arena, TypeId, 50 * 10), damage(damage) {
         renderOption = EntityRenderOptions::StrengthPotionRenderOption(damage);
     }
 
     bool StrengthPotion::PickUp(Entity* by) {
         if (IsType(by, EntityType::PLAYER)) {
-            dynamic_cast<Player*>(by)->ChangeDamage(damage);
-            pickedUp = true;
+            static_cast<Player*>(by)->ChangeDamage(damage);
+            markPickedUp();
             return true;
         }
 
         if (IsType(by, EntityType::ABSTRACT_MOB)) {
-            dynamic_cast<AbstractMob*>(by)->ChangeDamage(damage);
-            pickedUp = true;
+            static_cast<AbstractMob*>(by)->ChangeDamage(damage);
+            markPickedUp();
             return true;
         }
 
         if (IsType(by, EntityType::PLAYER_BULLET)) {
-            pickedUp = true; // bullet will shatter the strength potion, as if it was picked up
+            markPickedUp(); // bullet will shatter the strength potion, as if it was picked up
             return true;
         }
 
@@ -621,25 +617,25 @@ namespace core {
 
     //  BEGIN: Shield
 
-    Shield::Shield(Point position, Arena* arena, int duration) : AbstractCollectible(position, arena, 50 * 10), duration(duration) {
+    Shield::Shield(Point position, Arena* arena, int duration) : AbstractCollectible(position, arena, TypeId, 50 * 10), duration(duration) {
         renderOption = EntityRenderOptions::ShieldRenderOption();
     }
 
     bool Shield::PickUp(Entity* by) {
         if (IsType(by, EntityType::PLAYER)) {
-            dynamic_cast<Player*>(by)->ApplyShield(duration);
-            pickedUp = true;
+            static_cast<Player*>(by)->ApplyShield(duration);
+            markPickedUp();
             return true;
         }
 
         if (IsType(by, EntityType::ABSTRACT_MOB)) {
-            dynamic_cast<AbstractMob*>(by)->ApplyShield(duration);
-            pickedUp = true;
+            static_cast<AbstractMob*>(by)->ApplyShield(duration);
+            markPickedUp();
             return true;
         }
 
         if (IsType(by, EntityType::PLAYER_BULLET)) {
-            pickedUp = true; // bullet will shatter the shield, as if it was picked up
+            markPickedUp(); // bullet will shatter the shield, as if it was picked up
             return true;
         }
 
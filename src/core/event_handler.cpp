@@ -4,6 +4,8 @@
 #include <core/entity.hpp>
 #include <core/arena.hpp>
 #include <core/point.hpp>
+#include <core/pathfinding.hpp>
+#include <core/timer_wheel.hpp>
 
 // ftxui
 #include <ftxui/component/component.hpp>
@@ -14,13 +16,15 @@
 
 // util components
 #include <util/log.hpp>
+#include <util/trace.hpp>
+#include <util/worker_pool.hpp>
 
 // standard library
+#include <algorithm>
 #include <cstdlib>
 #include <chrono>
 #include <thread>
 #include <unordered_map>
-#include <queue>
 #include <string>
 #include <map>
 
@@ -70,8 +74,21 @@ namespace core {
         EventHandler::Fire();
     }
 
+    void RunEventHandler::FireHeadless(long long ticks) {
+        util::WriteToLog("RunEvent triggered without UI", "RunEventHandler::FireHeadless()");
+        startTrace();
+        initialiseEventHandler->Fire();
+        for (long long tick = 0; tick < ticks && GetGame()->IsRunning(); tick++) {
+            tickEventHandler->Fire();
+        }
+        util::WriteToLog("Headless game loop exited after " + std::to_string(GetGame()->GetGameClock()) + " ticks.", "RunEventHandler::FireHeadless()");
+        finishTrace();
+        writeHandlerProfiles();
+    }
+
     void RunEventHandler::execute() {
         //  Initialize the game.
+        startTrace();
         initialiseEventHandler->Fire();
         util::WriteToLog("InitialiseEventHandler fire completed.", "RunEventHandler::execute()");
 
@@ -85,11 +102,9 @@ namespace core {
             }
             //  The game will end with throw endType so there is no need of condition testing.
             util::WriteToLog("Game initialised. Starting tick event handler loop...", "RunEventHandler::execute() {thread: tickThread}");
-            while (GetGame()->IsRunning()) {
-                using namespace std::chrono_literals;
-                tickEventHandler->Fire();
-                std::this_thread::sleep_for(20ms);
-            }
+            runTickLoop();
+            finishTrace();
+            writeHandlerProfiles();
             util::WriteToLog("Game loop exited. Terminating tickThread...", "RunEventHandler::execute() {thread: tickThread}");
             GetGame()->SetTerminated();
         });
@@ -100,6 +115,85 @@ namespace core {
         ui::publicGameUIRenderer->StartRenderLoop();
     }
 
+    void RunEventHandler::runTickLoop() {
+        using Clock = std::chrono::steady_clock;
+        const auto period = std::chrono::microseconds(Game::TICK_MICROS);
+        const long long maxCatchUpTicks = std::max(0, GetGame()->GetOptions()->MaxCatchUpTicks);
+        TickTimingStats stats;
+        auto deadline = Clock::now();
+        while (GetGame()->IsRunning()) {
+            auto start = Clock::now();
+            tickEventHandler->Fire();
+            auto end = Clock::now();
+
+            long long workMicros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+            stats.Ticks++;
+            stats.LastTickMicros = static_cast<int>(workMicros);
+            if (workMicros > Game::TICK_MICROS) {
+                long long overrun = workMicros - Game::TICK_MICROS;
+                stats.Overruns++;
+                stats.TotalOverrunMicros += overrun;
+                stats.MaxOverrunMicros = std::max(stats.MaxOverrunMicros, overrun);
+            }
+
+            // Sleep until the next deadline. If it has passed already, run the next tick at once;
+            // the deadlines missed after it are caught up to the limit, and the rest are dropped.
+            deadline += period;
+            if (end >= deadline) {
+                long long missedTicks = (end - deadline) / period;
+                long long droppedTicks = std::max(0LL, missedTicks - maxCatchUpTicks);
+                deadline += droppedTicks * period;
+                stats.LateTicks++;
+                stats.DroppedTicks += droppedTicks;
+            }
+            GetGame()->SetTickTimingStats(stats);
+            if (end < deadline) std::this_thread::sleep_until(deadline);
+        }
+
+        util::WriteToLog("Tick loop ran " + std::to_string(stats.Ticks) + " ticks: "
+            + std::to_string(stats.Overruns) + " overran the " + std::to_string(Game::TICK_MICROS) + " us budget (max "
+            + std::to_string(stats.MaxOverrunMicros) + " us over, " + std::to_string(stats.TotalOverrunMicros) + " us in total), "
+            + std::to_string(stats.LateTicks) + " started late, " + std::to_string(stats.DroppedTicks) + " dropped.",
+            "RunEventHandler::runTickLoop()");
+        auto input = GetGame()->GetInputLatencyStats();
+        util::WriteToLog("Applied " + std::to_string(input.Commands) + " input commands, "
+            + std::to_string(input.Commands > 0 ? input.TotalMicros / input.Commands : 0) + " us after the key press on average (max "
+            + std::to_string(input.MaxMicros) + " us), " + std::to_string(input.Dropped) + " dropped.",
+            "RunEventHandler::runTickLoop()");
+    }
+
+    void RunEventHandler::startTrace() {
+        if (GetGame()->GetOptions()->TraceFile.empty()) return;
+        util::WriteToLog("Recording a trace to " + GetGame()->GetOptions()->TraceFile + ".", "RunEventHandler::startTrace()");
+        util::SetTracingEnabled(true);
+    }
+
+    void RunEventHandler::finishTrace() {
+        const std::string& traceFile = GetGame()->GetOptions()->TraceFile;
+        if (traceFile.empty()) return;
+        util::SetTracingEnabled(false);
+        long long spans = util::WriteTrace(traceFile);
+        if (spans < 0) {
+            util::WriteToLog("Failed to write the trace to " + traceFile + ".", "RunEventHandler::finishTrace()", "ERROR");
+            return;
+        }
+        util::WriteToLog("Wrote a trace of " + std::to_string(spans) + " spans to " + traceFile + " ("
+            + std::to_string(util::GetDroppedTraceSpans()) + " dropped).", "RunEventHandler::finishTrace()");
+    }
+
+    void RunEventHandler::writeHandlerProfiles() {
+        for (int i = 0; i < static_cast<int>(ProfiledHandler::COUNT); i++) {
+            auto handler = static_cast<ProfiledHandler>(i);
+            const auto& profile = GetGame()->GetHandlerProfile(handler);
+            util::WriteToLog(std::string(GetProfiledHandlerName(handler)) + ": " + std::to_string(profile.GetCount()) + " runs, p50 "
+                + std::to_string(profile.GetPercentile(50)) + " us, p99 " + std::to_string(profile.GetPercentile(99)) + " us, max "
+                + std::to_string(profile.GetMax()) + " us.", "RunEventHandler::writeHandlerProfiles()");
+        }
+        if (!GetGame()->WriteHandlerProfiles(HANDLER_PROFILE_FILE)) {
+            util::WriteToLog("Failed to write the handler profiles to " + std::string(HANDLER_PROFILE_FILE) + ".", "RunEventHandler::writeHandlerProfiles()", "ERROR");
+        }
+    }
+
     //  END: RunEventHandler
 
     //  BEGIN: InitialiseEventHandler
@@ -119,9 +213,8 @@ namespace core {
         GetGame()->InitialiseArena();
         GetGame()->GetArena()->SetGame(GetGame());
 
-        //  Pollinate the random number generator seed
-        util::WriteToLog("Seeding random number generator...", "InitialiseEventHandler::InitialiseEventHandler()");
-        std::srand(std::chrono::system_clock::now().time_since_epoch().count());
+        //  The random number streams are seeded when the game is constructed
+        util::WriteToLog("Random seed: " + std::to_string(GetGame()->GetSeed()), "InitialiseEventHandler::InitialiseEventHandler()");
 
         //  Create player if it doesn't exist
         //  NOTE: The player MUST be the first non-block entity to have the ID 0.
@@ -137,6 +230,8 @@ namespace core {
         }
         util::WriteToLog("InitialiseEventHandler constructed.", "InitialiseEventHandler::InitialiseEventHandler()");
 
+        //  Give the UI a frame to draw before the first tick
+        if (!GetGame()->IsHeadless()) GetGame()->PublishFrame();
         GetGame()->SetInitialisationComplete();
     }
 
@@ -150,6 +245,7 @@ namespace core {
     }
 
     void PlayerMoveEventHandler::Fire() {
+        util::TraceSpan span("PlayerMoveEventHandler::Fire");
         execute(movementDirection);
         EventHandler::Fire();
     }
@@ -193,9 +289,7 @@ namespace core {
                 SetDirection(Direction::STILL);
                 break;
         }
-
-        //  Redraw UI
-        ui::appScreen.PostEvent(ftxui::Event::Custom);
+        //  The UI is redrawn by the tick that applied the move.
     }
 
     // END: PlayerMoveEventHandler
@@ -214,9 +308,10 @@ namespace core {
         playerMoveEventHandler = new PlayerMoveEventHandler(game);
         playerShootEventHandler = new PlayerShootEventHandler(game);
         bulletMoveEventHandler = dynamic_cast<BulletMoveEventHandler*>(subevents[2]);
-        game->PlayerMoveEventHandlerPtr = playerMoveEventHandler; // expose handler to UI
-        game->PlayerShootEventHandlerPtr = playerShootEventHandler; // expose handler to UI
+        game->PlayerMoveEventHandlerPtr = playerMoveEventHandler; // expose handler to Game
+        game->PlayerShootEventHandlerPtr = playerShootEventHandler; // expose handler to Game
         game->BulletMoveEventHandlerPtr = bulletMoveEventHandler; // expose handler to Game
+        game->MobMoveEventHandlerPtr = static_cast<MobMoveEventHandler*>(subevents[1]); // expose pathfinding stats
     }
 
     TickEventHandler::~TickEventHandler() {
@@ -228,13 +323,44 @@ namespace core {
     }
 
     void TickEventHandler::Fire() {
+        util::TraceSpan span("TickEventHandler::Fire");
+        util::LatencyTimer timer(GetGame()->GetHandlerProfile(ProfiledHandler::TICK));
         execute();
         EventHandler::Fire();
+        //  Hand the state at the end of the tick to the UI, and have it redrawn if it changed
+        if (GetGame()->IsHeadless()) return;
+        util::LatencyTimer publishTimer(GetGame()->GetHandlerProfile(ProfiledHandler::PUBLISH_FRAME));
+        bool changed = GetGame()->PublishFrame();
+        if (GetGame()->RequestRedraw(changed)) ui::appScreen.Post(ftxui::Event::Custom);
     }
     
     void TickEventHandler::execute() {
         GetGame()->IncrementGameClock();
-        ui::appScreen.Post(ftxui::Event::Custom);
+        applyInput();
+    }
+
+    void TickEventHandler::applyInput() {
+        util::LatencyTimer timer(GetGame()->GetHandlerProfile(ProfiledHandler::INPUT));
+        InputCommand command;
+        bool applied = false;
+        while (GetGame()->PopInput(command)) {
+            auto now = std::chrono::steady_clock::now().time_since_epoch();
+            long long waitMicros = std::chrono::duration_cast<std::chrono::microseconds>(now).count() - command.PushedAtMicros;
+            inputLatencyStats.Commands++;
+            inputLatencyStats.TotalMicros += waitMicros;
+            inputLatencyStats.MaxMicros = std::max(inputLatencyStats.MaxMicros, waitMicros);
+            inputLatencyStats.LastMicros = static_cast<int>(waitMicros);
+            applied = true;
+
+            if (command.CommandType == InputCommand::Type::MOVE) {
+                playerMoveEventHandler->SetDirection(static_cast<PlayerMoveEventHandler::Direction>(command.Direction));
+                playerMoveEventHandler->Fire();
+            } else {
+                playerShootEventHandler->SetBulletDirection(command.Direction);
+                playerShootEventHandler->Fire();
+            }
+        }
+        if (applied) GetGame()->SetInputLatencyStats(inputLatencyStats);
     }
     
     //  END: TickEventHandler
@@ -246,6 +372,7 @@ namespace core {
     }
 
     void PlayerShootEventHandler::Fire() {
+        util::TraceSpan span("PlayerShootEventHandler::Fire");
         execute();
         EventHandler::Fire();
     }
@@ -282,6 +409,8 @@ namespace core {
     BulletMoveEventHandler::BulletMoveEventHandler(Game* game) : EventHandler(game) { }
 
     void BulletMoveEventHandler::Fire() {
+        util::TraceSpan span("BulletMoveEventHandler::Fire");
+        util::LatencyTimer timer(GetGame()->GetHandlerProfile(ProfiledHandler::BULLET_MOVE));
         execute();
         EventHandler::Fire();
     }
@@ -321,6 +450,8 @@ namespace core {
     }
 
     void MobGenerateEventHandler::Fire() {
+        util::TraceSpan span("MobGenerateEventHandler::Fire");
+        util::LatencyTimer timer(GetGame()->GetHandlerProfile(ProfiledHandler::MOB_GENERATE));
         // util::WriteToLog("MobGenerateEvent triggered", "MobGenerateEventHandler::Fire()");
         execute();
         EventHandler::Fire();
@@ -332,7 +463,7 @@ namespace core {
 
         if (countMobs() >= GetGame()->GetOptions()->MaxMobs) return;
 
-        util::WriteToLog("Spawning mob...", "MobGenerateEventHandler::execute()");
+        LOG_DEBUG("Spawning mob...", "MobGenerateEventHandler::execute()");
         spawnMob();
         lastSpawnTick = currentTime;
     }
@@ -353,12 +484,14 @@ namespace core {
     void MobGenerateEventHandler::spawnMob() {
         Arena* arena = GetGame()->GetArena();
         
+        util::Random& random = GetGame()->GetRandom(RandomStream::MOB_SPAWN);
+
         // Find a valid spawn position (must be air)
         Point spawnPos = {0, 0};
         int attempts = 0;
         while (attempts < 20) {
-            spawnPos.x = std::rand() % ARENA_WIDTH;
-            spawnPos.y = std::rand() % ARENA_HEIGHT;
+            spawnPos.x = random.NextInt(ARENA_WIDTH);
+            spawnPos.y = random.NextInt(ARENA_HEIGHT);
             
             Entity* currentEntity = arena->GetPixel(spawnPos);
             if (!Entity::IsType(currentEntity, EntityType::AIR)) {
@@ -366,7 +499,7 @@ namespace core {
                 continue;
             }
             auto it = GetGame()->GetOptions()->MobTypesGenerated.begin();
-            std::advance(it, std::rand() % GetGame()->GetOptions()->MobTypesGenerated.size());
+            std::advance(it, random.NextInt(GetGame()->GetOptions()->MobTypesGenerated.size()));
             EntityType mobType = *it;
             AbstractMob* mob;
             switch (mobType) {
@@ -393,9 +526,10 @@ namespace core {
             }
             bool success = arena->SetPixelWithIdSafe(spawnPos, mob);
             if (success) {
-                util::WriteToLog("Mob spawned successfully at (" + std::to_string(spawnPos.x) + ", " + std::to_string(spawnPos.y) + ")", "MobGenerateEventHandler::spawnMob()");
+                GetGame()->GetScheduler()->Schedule(mob, mob->GetNextWakeupTick());
+                LOG_DEBUG("Mob spawned successfully at (" + std::to_string(spawnPos.x) + ", " + std::to_string(spawnPos.y) + ")", "MobGenerateEventHandler::spawnMob()");
             } else {
-                util::WriteToLog("Failed to spawn mob at (" + std::to_string(spawnPos.x) + ", " + std::to_string(spawnPos.y) + ")", "MobGenerateEventHandler::spawnMob()");
+                LOG_DEBUG("Failed to spawn mob at (" + std::to_string(spawnPos.x) + ", " + std::to_string(spawnPos.y) + ")", "MobGenerateEventHandler::spawnMob()");
                 delete mob;
             } 
             break;
@@ -409,124 +543,292 @@ namespace core {
     MobMoveEventHandler::MobMoveEventHandler(Game* game) : EventHandler(game) {
         playerPrevPos = {-1, -1}; // Initial value to ensure pathfinding is done at the start
         prevMobCount = 0;
+        playerField = new FlowField();
+        energyDrinkField = new FlowField();
+        snapshot = new OccupancySnapshot();
+    }
+
+    MobMoveEventHandler::~MobMoveEventHandler() {
+        if (planningTicks > 0) {
+            util::WriteToLog("Average path planning time: " + std::to_string(totalPlanningMicros / planningTicks)
+                + " us per tick over " + std::to_string(planningTicks) + " ticks, "
+                + std::to_string(workers->GetWorkerCount()) + " workers.", "MobMoveEventHandler::~MobMoveEventHandler()");
+        }
+        delete workers;
+        delete playerField;
+        delete energyDrinkField;
+        delete snapshot;
+        for (auto pathfinder : pathfinders) delete pathfinder;
+        for (auto& entry : mobPathfinders) delete entry.second;
+        delete cooperativePlanner;
+        delete reservations;
     }
 
     void MobMoveEventHandler::Fire() {
+        util::TraceSpan span("MobMoveEventHandler::Fire");
+        util::LatencyTimer timer(GetGame()->GetHandlerProfile(ProfiledHandler::MOB_MOVE));
         execute();
         EventHandler::Fire();
     }
     
+    PathfindingStats MobMoveEventHandler::GetLastTickStats() const {
+        return lastTickStats;
+    }
+
     void MobMoveEventHandler::execute() {
+        tickStats = PathfindingStats();
         auto playerPos = GetGame()->GetArena()->GetPixelById(0)->GetPosition();
-        // Move all mobs
-        auto entities = GetGame()->GetArena()->GetMappedEntities();
-        int mobCount = 0;
-        for (auto entity : entities) {
-            if (!Entity::IsType(entity, EntityType::ABSTRACT_MOB)) continue;
-            auto mob = dynamic_cast<AbstractMob*>(entity);
-            if (mob == nullptr) continue;
+        long long now = GetGame()->GetGameClock();
+        // Move the mobs that are due, in spawn order
+        std::vector<Entity*> dueMobs;
+        GetGame()->GetScheduler()->TakeDue(EntityType::ABSTRACT_MOB, dueMobs);
+        std::sort(dueMobs.begin(), dueMobs.end(), [](Entity* a, Entity* b) { return a->Id < b->Id; });
+        for (auto entity : dueMobs) {
+            auto mob = static_cast<AbstractMob*>(entity);
             // Check if the mob is dead
             if (mob->GetHP() <= 0) {
                 GetGame()->ChangeScore(mob->GetKillScore());
+                auto ownPathfinder = mobPathfinders.find(mob->Id);
+                if (ownPathfinder != mobPathfinders.end()) {
+                    delete ownPathfinder->second;
+                    mobPathfinders.erase(ownPathfinder);
+                }
+                if (reservations != nullptr) reservations->Release(mob->Id);
+                GetGame()->GetScheduler()->Cancel(mob);
                 GetGame()->GetArena()->RemoveById(mob->Id);
                 continue;
             }
-            mobCount++;
             mob->Move();
+            // a mob that could not move (blocked, or no path yet) tries again next tick
+            GetGame()->GetScheduler()->Schedule(mob, std::max(mob->GetNextWakeupTick(), now + 1));
         }
         playerPrevPos = playerPos;
 
         // Perform pathfinding for all mobs
-        entities = GetGame()->GetArena()->GetMappedEntities(); // refresh entity list to exclude dead mobs
+        auto entities = GetGame()->GetArena()->GetMappedEntities();
+        switch (GetGame()->GetOptions()->MobPathfinding) {
+            case PathfindingAlgorithm::A_STAR:
+            case PathfindingAlgorithm::JUMP_POINT_SEARCH:
+            case PathfindingAlgorithm::HIERARCHICAL:
+            case PathfindingAlgorithm::D_STAR_LITE:
+            case PathfindingAlgorithm::COOPERATIVE:
+                findPathsPerMob(entities, playerPos);
+                break;
+            case PathfindingAlgorithm::FLOW_FIELD:
+            default:
+                followFlowFields(entities, playerPos);
+                break;
+        }
+        lastTickStats = tickStats;
+    }
+
+    void MobMoveEventHandler::followFlowFields(const std::vector<Entity*>& entities, Point playerPos) {
+        GetGame()->GetArena()->TakeSnapshot(*snapshot);
+
+        // Walls never change during a game, so the fields only need to be recomputed
+        // when their sources (the player, the energy drinks) have moved.
+        std::vector<Point> playerSources = {playerPos};
+        if (!playerField->IsComputedFrom(playerSources)) playerField->Compute(*snapshot, playerSources);
+
+        bool energyDrinkFieldReady = false;
         for (auto entity : entities) {
             if (!Entity::IsType(entity, EntityType::ABSTRACT_MOB)) continue;
-            auto mob = dynamic_cast<AbstractMob*>(entity);
-            if (mob == nullptr) continue;
+            auto mob = static_cast<AbstractMob*>(entity);
+            Point mobPos = mob->GetPosition();
+            FlowField* field = playerField;
 
-            std::map<int, Point> targets = {{heuristic(playerPos, entity->GetPosition()), playerPos}};
             // prioritise energy drink over player if the mob is about to die (HP = 1)
             if (mob->GetHP() == 1) {
-                auto collectibles = GetGame()->GetArena()->GetEntitiesOfType(EntityType::ENERGY_DRINK);
-                for (auto collectible : collectibles) {
-                    if (collectible == nullptr) continue;
-                    auto collectiblePos = collectible->GetPosition();
-                    targets[heuristic(collectiblePos, entity->GetPosition())] = collectiblePos;
+                if (!energyDrinkFieldReady) {
+                    std::vector<Point> drinkSources;
+                    for (auto drink : GetGame()->GetArena()->GetEntitiesOfType(EntityType::ENERGY_DRINK)) {
+                        drinkSources.push_back(drink->GetPosition());
+                    }
+                    if (!energyDrinkField->IsComputedFrom(drinkSources)) energyDrinkField->Compute(*snapshot, drinkSources);
+                    energyDrinkFieldReady = true;
+                }
+                int drinkDistance = energyDrinkField->GetDistance(mobPos);
+                int playerDistance = playerField->GetDistance(mobPos);
+                if (drinkDistance != FlowField::UNREACHABLE
+                    && (playerDistance == FlowField::UNREACHABLE || drinkDistance <= playerDistance)) {
+                    field = energyDrinkField;
                 }
             }
+
+            Point next = field->NextStep(mobPos, *snapshot);
+            mob->Path.clear();
+            if (next != mobPos) mob->Path.push_back(next);
+        }
+    }
+
+    void MobMoveEventHandler::findPathsPerMob(const std::vector<Entity*>& entities, Point playerPos) {
+        GetGame()->GetArena()->TakeSnapshot(*snapshot);
+        long long now = GetGame()->GetGameClock();
+
+        // Queue a request for every mob that needs a new path
+        std::unordered_map<int, AbstractMob*> mobs;
+        for (auto entity : entities) {
+            if (!Entity::IsType(entity, EntityType::ABSTRACT_MOB)) continue;
+            auto mob = static_cast<AbstractMob*>(entity);
+            mobs[mob->Id] = mob;
             if (playerPos == playerPrevPos 
-                && mob->Path.back() == playerPos
-                && Entity::IsType(GetGame()->GetArena()->GetPixel(mob->Path.front()), EntityType::AIR)) {
+                && !mob->Path.empty()
+                && mob->PathGoal == playerPos
+                && (snapshot->At(mob->Path.front()) == EntityType::AIR
+                    || mob->Path.front() == mob->GetPosition()
+                    || mob->Path.front() == playerPos)) {
                 // skip path finding if:
                 //    player has not moved
                 //    already on the way to player
-                //    the mob is not stopped by other blocks
+                //    the mob is not stopped by other blocks (it may wait on purpose, or attack the player)
                 continue;
             }
-            mob->Path = findPath(GetGame()->GetArena(), mob->GetPosition(), targets.begin()->second);
+            if (pathRequestTicks.count(mob->Id)) continue; // already waiting
+            pathRequests.push_back(mob->Id);
+            pathRequestTicks[mob->Id] = now;
         }
-    }
 
-    std::list<Point> MobMoveEventHandler::findPath(Arena* arena, Point start, Point end) {
-        // References:
-        // - https://www.redblobgames.com/pathfinding/a-star/introduction.html
-        // - https://www.redblobgames.com/pathfinding/a-star/implementation.html#cpp-astar
-        typedef std::pair<int, Point> Node;
-        std::unordered_map<Point, Point> cameFrom;
-        std::unordered_map<Point, int> costSoFar;
-        std::priority_queue<Node, std::vector<Node>, std::greater<Node>> frontier;
-
-        frontier.emplace(0, start);
-        cameFrom[start] = start;
-        costSoFar[start] = 0;
-
-        while (!frontier.empty()) {
-            Point current = frontier.top().second;
-            frontier.pop();
-            if (current == end) break;
-
-            for (auto next : getNeighbours(current)) {
-                if (Entity::IsType(arena->GetPixel(next), EntityType::WALL)) continue; // Skip walls
-                if (Entity::IsType(arena->GetPixel(next), EntityType::ABSTRACT_MOB)) continue; // Skip other mobs
-                int newCost = costSoFar[current] + 1;
-                if (costSoFar.find(next) == costSoFar.end() || newCost < costSoFar[next]) {
-                    costSoFar[next] = newCost;
-                    frontier.emplace(newCost + heuristic(next, end), next);
-                    cameFrom[next] = current;
-                }
+        if (GetGame()->GetOptions()->MobPathfinding == PathfindingAlgorithm::COOPERATIVE) {
+            if (reservations == nullptr) {
+                cooperativePlanner = new CooperativePlanner();
+                reservations = new ReservationTable();
             }
+            reservations->Prune(now);
+            std::vector<Point> playerSources = {playerPos};
+            if (!playerField->IsComputedFrom(playerSources)) playerField->Compute(*snapshot, playerSources);
         }
 
-        // Reconstruct path
-        std::list<Point> path;
-        Point current = end; // include end point (player position) in path for collision
-        if (cameFrom.find(end) == cameFrom.end()) return path; // No path found
-        while (current != start) {
-            path.push_front(current);
-            current = cameFrom[current];
+        // Serve the requests in order until the budget runs out. At least one batch is served
+        // every tick, so the queue drains however small the budget is.
+        if (workers == nullptr) workers = new util::WorkerPool(GetGame()->GetOptions()->PathfindingWorkers);
+        bool cooperative = GetGame()->GetOptions()->MobPathfinding == PathfindingAlgorithm::COOPERATIVE;
+        int batchSize = cooperative || workers->GetWorkerCount() == 1 ? 1 : workers->GetWorkerCount() * 4;
+        int budget = GetGame()->GetOptions()->PathfindingBudgetMicros;
+        auto start = std::chrono::steady_clock::now();
+        bool served = false;
+        std::vector<PathRequest> batch;
+        while (!pathRequests.empty()) {
+            if (budget > 0 && served
+                && std::chrono::steady_clock::now() - start >= std::chrono::microseconds(budget)) break;
+            batch.clear();
+            while (!pathRequests.empty() && (int) batch.size() < batchSize) {
+                int id = pathRequests.front();
+                pathRequests.pop_front();
+                long long requestTick = pathRequestTicks[id];
+                pathRequestTicks.erase(id);
+                auto mob = mobs.find(id);
+                if (mob == mobs.end()) continue; // the mob died while waiting
+
+                int waitTicks = static_cast<int>(now - requestTick);
+                tickStats.TotalWaitTicks += waitTicks;
+                tickStats.MaxWaitTicks = std::max(tickStats.MaxWaitTicks, waitTicks);
+                batch.push_back({mob->second, mob->second->GetPosition(), chooseTarget(mob->second, playerPos),
+                    pathfinderFor(mob->second)});
+            }
+            planBatch(batch);
+            served = true;
+        }
+        tickStats.QueueDepth = static_cast<int>(pathRequests.size());
+        tickStats.Workers = workers->GetWorkerCount();
+        if (served) {
+            tickStats.PlanningMicros = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            totalPlanningMicros += tickStats.PlanningMicros;
+            planningTicks++;
         }
+    }
 
-        return path;
+    void MobMoveEventHandler::planBatch(std::vector<PathRequest>& batch) {
+        if (batch.empty()) return;
+        if (batch.front().Engine == nullptr) {
+            for (auto& request : batch) planCooperatively(request);
+        } else {
+            // Jobs are handed out dynamically, so the worker running a request is only known
+            // once it runs. Shared pathfinders are then swapped for the one of that worker.
+            bool shared = GetGame()->GetOptions()->MobPathfinding != PathfindingAlgorithm::D_STAR_LITE;
+            workers->Run(static_cast<int>(batch.size()), [this, &batch, shared](int index, int worker) {
+                auto& request = batch[index];
+                if (shared) request.Engine = pathfinders[worker];
+                findPath(request);
+            });
+        }
+        for (auto& request : batch) {
+            request.Mob->Path = std::move(request.Path);
+            request.Mob->PathGoal = request.Target;
+            tickStats.Queries++;
+            tickStats.Expansions += request.Expansions;
+            if (request.Incremental) {
+                tickStats.Repairs++;
+                tickStats.RepairExpansions += request.Expansions;
+            }
+        }
     }
 
-    int MobMoveEventHandler::heuristic(Point a, Point b) {
-        return std::abs(a.x - b.x) + std::abs(a.y - b.y);
+    Point MobMoveEventHandler::chooseTarget(AbstractMob* mob, Point playerPos) {
+        std::map<int, Point> targets = {{heuristic(playerPos, mob->GetPosition()), playerPos}};
+        // prioritise energy drink over player if the mob is about to die (HP = 1)
+        if (mob->GetHP() == 1) {
+            auto collectibles = GetGame()->GetArena()->GetEntitiesOfType(EntityType::ENERGY_DRINK);
+            for (auto collectible : collectibles) {
+                if (collectible == nullptr) continue;
+                auto collectiblePos = collectible->GetPosition();
+                targets[heuristic(collectiblePos, mob->GetPosition())] = collectiblePos;
+            }
+        }
+        return targets.begin()->second;
     }
 
-    std::list<Point> MobMoveEventHandler::getNeighbours(Point point) {
-        std::list<Point> neighbours;
-        for (int dx = -1; dx <= 1; ++dx) {
-            for (int dy = -1; dy <= 1; ++dy) {
-                if (dx == 0 && dy == 0) continue;
-                int nx = point.x + dx;
-                int ny = point.y + dy;
-                if (nx >= 1 && nx < ARENA_WIDTH - 1 && ny >= 1 && ny < ARENA_HEIGHT - 1) {
-                    neighbours.push_back({nx, ny});
-                }
+    Pathfinder* MobMoveEventHandler::pathfinderFor(Entity* mob) {
+        switch (GetGame()->GetOptions()->MobPathfinding) {
+            case PathfindingAlgorithm::COOPERATIVE:
+                return nullptr;
+            case PathfindingAlgorithm::D_STAR_LITE: {
+                auto& ownPathfinder = mobPathfinders[mob->Id];
+                if (ownPathfinder == nullptr) ownPathfinder = new DStarLitePathfinder();
+                return ownPathfinder;
             }
+            default:
+                if (pathfinders.empty()) {
+                    for (int i = 0; i < workers->GetWorkerCount(); i++) pathfinders.push_back(createPathfinder());
+                }
+                return pathfinders.front();
         }
-        return neighbours;
     }
-    
+
+    Pathfinder* MobMoveEventHandler::createPathfinder() {
+        switch (GetGame()->GetOptions()->MobPathfinding) {
+            case PathfindingAlgorithm::JUMP_POINT_SEARCH: return new JumpPointPathfinder();
+            case PathfindingAlgorithm::HIERARCHICAL: return new HierarchicalPathfinder(GetGame()->GetArena()->GetClusterGraph());
+            case PathfindingAlgorithm::A_STAR:
+            default: return new AStarPathfinder();
+        }
+    }
+
+    void MobMoveEventHandler::findPath(PathRequest& request) {
+        util::TraceSpan span("MobMoveEventHandler::findPath");
+        request.Path = request.Engine->FindPath(*snapshot, request.Start, request.Target);
+        request.Expansions = request.Engine->GetLastExpansions();
+        request.Incremental = request.Engine->WasLastQueryIncremental();
+    }
+
+    void MobMoveEventHandler::planCooperatively(PathRequest& request) {
+        util::TraceSpan span("MobMoveEventHandler::planCooperatively");
+        // the player field is kept up to date by findPathsPerMob(), other targets use the drink field
+        std::vector<Point> sources = {request.Target};
+        FlowField* field = playerField->IsComputedFrom(sources) ? playerField : energyDrinkField;
+        if (!field->IsComputedFrom(sources)) field->Compute(*snapshot, sources);
+
+        long long now = GetGame()->GetGameClock();
+        long long firstStepTick = std::max(now + 1, request.Mob->GetNextMoveTick());
+        request.Path = cooperativePlanner->PlanPath(*snapshot, *field, *reservations,
+            request.Mob->Id, request.Start, request.Target, now, firstStepTick, request.Mob->GetTicksPerMove());
+        request.Expansions = cooperativePlanner->GetLastExpansions();
+    }
+
+    int MobMoveEventHandler::heuristic(Point a, Point b) {
+        return std::abs(a.x - b.x) + std::abs(a.y - b.y);
+    }
+
     //  END: MobMoveEventHandler
 
     //  BEGIN: CollectiblesEventHandler
@@ -536,30 +838,36 @@ namespace core {
     }
 
     void CollectiblesEventHandler::Fire() {
+        util::TraceSpan span("CollectiblesEventHandler::Fire");
+        util::LatencyTimer timer(GetGame()->GetHandlerProfile(ProfiledHandler::COLLECTIBLES));
         execute();
         EventHandler::Fire();
     }
 
     void CollectiblesEventHandler::execute() {
-        // refresh all existing collectibles
-        auto entities = GetGame()->GetArena()->GetEntitiesOfType(EntityType::ABSTRACT_COLLECTIBLE);
-        for (auto entity : entities) {
-            auto collectible = dynamic_cast<AbstractCollectible*>(entity);
-            if (collectible == nullptr) continue;
+        // refresh the collectibles that are due: about to blink, expired or picked up
+        std::vector<Entity*> dueCollectibles;
+        GetGame()->GetScheduler()->TakeDue(EntityType::ABSTRACT_COLLECTIBLE, dueCollectibles);
+        for (auto entity : dueCollectibles) {
+            auto collectible = static_cast<AbstractCollectible*>(entity);
             collectible->RefreshStatus();
 
             // Remove expired collectibles
             if (collectible->IsInvalid()) {
+                GetGame()->GetScheduler()->Cancel(collectible);
                 GetGame()->GetArena()->Remove(collectible->GetPosition());
+                continue;
             }
+            GetGame()->GetScheduler()->Schedule(collectible, collectible->GetNextWakeupTick());
         }
 
         // Spawn new collectibles
         long long currentTime = GetGame()->GetGameClock();
         if (currentTime - lastSpawnTick < 3 * 50) return; // collectibles spawn every 10 seconds
+        util::Random& random = GetGame()->GetRandom(RandomStream::COLLECTIBLE_SPAWN);
         int attempts = 0;
         while (attempts < 10) {
-            Point spawnPos = {std::rand() % ARENA_WIDTH, std::rand() % ARENA_HEIGHT};
+            Point spawnPos = {random.NextInt(ARENA_WIDTH), random.NextInt(ARENA_HEIGHT)};
             Entity* currentEntity = GetGame()->GetArena()->GetPixel(spawnPos);
             if (!Entity::IsType(currentEntity, EntityType::AIR)) {
                 attempts++;
@@ -571,18 +879,18 @@ namespace core {
                 EntityType::SHIELD,
             };
             auto it = collectibleTypes.begin();
-            std::advance(it, std::rand() % collectibleTypes.size());
+            std::advance(it, random.NextInt(collectibleTypes.size()));
             EntityType collectibleType = *it;
             AbstractCollectible* collectible;
             switch (collectibleType) {
                 case EntityType::ENERGY_DRINK:
-                    collectible = new EnergyDrink(spawnPos, GetGame()->GetArena(), std::rand() % 9 + 1); // random HP (1-9)
+                    collectible = new EnergyDrink(spawnPos, GetGame()->GetArena(), random.NextInt(1, 9)); // random HP (1-9)
                     break;
                 case EntityType::STRENGTH_POTION:
-                    collectible = new StrengthPotion(spawnPos, GetGame()->GetArena(), std::rand() % 9 + 1); // random damage (1-9)
+                    collectible = new StrengthPotion(spawnPos, GetGame()->GetArena(), random.NextInt(1, 9)); // random damage (1-9)
                     break;
                 case EntityType::SHIELD:
-                    collectible = new Shield(spawnPos, GetGame()->GetArena(), std::rand() % 450 + 150); // random shield duration (150 - 600 ticks)
+                    collectible = new Shield(spawnPos, GetGame()->GetArena(), random.NextInt(150, 599)); // random shield duration (150 - 600 ticks)
                     break;
                 default:
                     util::WriteToLog("Unknown collectible type: " + std::to_string(static_cast<int>(collectibleType)), "CollectiblesEventHandler::execute()");
@@ -592,6 +900,7 @@ namespace core {
                 delete collectible;
                 continue;
             }
+            GetGame()->GetScheduler()->Schedule(collectible, collectible->GetNextWakeupTick());
             break;
         }
         lastSpawnTick = currentTime;
@@ -1,13 +1,44 @@
 #include <core/game.hpp>
+#include <core/arena.hpp>
+#include <core/timer_wheel.hpp>
 #include <util/log.hpp>
+#include <util/trace.hpp>
 
+#include <chrono>
+#include <fstream>
 #include <thread>
 
 namespace core {
 
+    const char* GetProfiledHandlerName(ProfiledHandler handler) {
+        switch (handler) {
+            case ProfiledHandler::TICK: return "Tick";
+            case ProfiledHandler::INPUT: return "Input";
+            case ProfiledHandler::MOB_GENERATE: return "MobGenerate";
+            case ProfiledHandler::MOB_MOVE: return "MobMove";
+            case ProfiledHandler::BULLET_MOVE: return "BulletMove";
+            case ProfiledHandler::COLLECTIBLES: return "Collectibles";
+            case ProfiledHandler::PUBLISH_FRAME: return "PublishFrame";
+            default: return "?";
+        }
+    }
+
     //  -- Game class ---------------------------------------------
 
-    Game::Game(GameOptions* options) : options(options) { }
+    Game::Game(GameOptions* options) : options(options) {
+        scheduler = new TimerWheel(gameClock.load());
+        inputQueue = new util::SpscQueue<InputCommand, INPUT_QUEUE_CAPACITY>();
+        frames = new util::TripleBuffer<FrameSnapshot>();
+        handlerProfiles = new util::LatencyHistogram[static_cast<int>(ProfiledHandler::COUNT)];
+
+        // Split one generator into a stream per subsystem
+        seed = options->Seed != 0 ? options->Seed : std::chrono::system_clock::now().time_since_epoch().count();
+        util::Random random(seed);
+        for (int i = 0; i < static_cast<int>(RandomStream::COUNT); i++) {
+            randomStreams.push_back(random);
+            random.Jump();
+        }
+    }
 
     Game::~Game() {
         util::WriteToLog("Deleting game...", "Game::~Game()");
@@ -17,6 +48,10 @@ namespace core {
         }
         delete runEventHandler;
         if (arenaIsDynamicallyCreated) delete arena;
+        delete scheduler;
+        delete inputQueue;
+        delete frames;
+        delete[] handlerProfiles;
         util::WriteToLog("Game deleted successfully.", "Game::~Game()");
     }
 
@@ -31,6 +66,18 @@ namespace core {
         return -1;
     }
 
+    int Game::RunHeadless(long long ticks) {
+        util::WriteToLog("Starting headless game for at most " + std::to_string(ticks) + " ticks...", "Game::RunHeadless()");
+        headless = true;
+        running = true;
+        auto runHandler = new RunEventHandler(this);
+        runEventHandler = runHandler;
+        runHandler->FireHeadless(ticks);
+        if (running) Terminate(2);
+        SetTerminated();
+        return GetScore();
+    }
+
     void Game::Terminate(int reason) {
         util::WriteToLog("Game termination requested.", "Game::Terminate()");
         terminateReason = reason;
@@ -42,6 +89,10 @@ namespace core {
         return running;
     }
 
+    bool Game::IsHeadless() const {
+        return headless;
+    }
+
     bool Game::IsInitialised() const {
         return initialisationComplete;
     }
@@ -84,6 +135,7 @@ namespace core {
             } else {
                 util::WriteToLog("Using default arena.", "Game::InitialiseArena()");
                 arena = new Arena();
+                arena->BuildClusterGraph();
                 arenaIsDynamicallyCreated = true;
             }
             arenaInitialised = true;
@@ -102,11 +154,147 @@ namespace core {
     }
 
     void Game::IncrementGameClock() {
-        gameClock.fetch_add(1);
+        scheduler->Advance(gameClock.fetch_add(1) + 1);
     }
 
     long long Game::GetGameClock() const {
         return gameClock.load();
     }
 
+    TimerWheel* Game::GetScheduler() const {
+        return scheduler;
+    }
+
+    util::Random& Game::GetRandom(RandomStream stream) {
+        return randomStreams[static_cast<int>(stream)];
+    }
+
+    std::uint64_t Game::GetSeed() const {
+        return seed;
+    }
+
+    TickTimingStats Game::GetTickTimingStats() {
+        std::lock_guard<std::mutex> lock(gameMutex);
+        return tickTimingStats;
+    }
+
+    void Game::SetTickTimingStats(const TickTimingStats& stats) {
+        std::lock_guard<std::mutex> lock(gameMutex);
+        tickTimingStats = stats;
+    }
+
+    bool Game::PushInput(InputCommand::Type type, int direction) {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        InputCommand command = {type, static_cast<std::uint8_t>(direction),
+            std::chrono::duration_cast<std::chrono::microseconds>(now).count()};
+        if (inputQueue->Push(command)) return true;
+        droppedInputs++;
+        return false;
+    }
+
+    bool Game::PopInput(InputCommand& command) {
+        return inputQueue->Pop(command);
+    }
+
+    InputLatencyStats Game::GetInputLatencyStats() {
+        std::lock_guard<std::mutex> lock(gameMutex);
+        auto stats = inputLatencyStats;
+        stats.Dropped = droppedInputs.load();
+        return stats;
+    }
+
+    void Game::SetInputLatencyStats(const InputLatencyStats& stats) {
+        std::lock_guard<std::mutex> lock(gameMutex);
+        inputLatencyStats = stats;
+    }
+
+    bool Game::PublishFrame() {
+        util::TraceSpan span("Game::PublishFrame");
+        auto& frame = frames->GetBack();
+        bool changed = arena->TakeFrame(frame);
+        auto player = dynamic_cast<Player*>(arena->GetPixelById(0));
+        if (player) {
+            frame.PlayerPosition = player->GetPosition();
+            frame.PlayerHp = player->GetHP();
+            frame.PlayerDamage = player->GetDamage();
+        }
+        frame.Score = GetScore();
+        frame.Tick = GetGameClock();
+
+        //  The back buffer holds an older frame, so compare with what was last published
+        if (frame.PlayerPosition != publishedPlayerPosition || frame.PlayerHp != publishedPlayerHp
+            || frame.PlayerDamage != publishedPlayerDamage || frame.Score != publishedScore) {
+            publishedPlayerPosition = frame.PlayerPosition;
+            publishedPlayerHp = frame.PlayerHp;
+            publishedPlayerDamage = frame.PlayerDamage;
+            publishedScore = frame.Score;
+            changed = true;
+        }
+        //  An unchanged frame is not published, so the UI keeps the one it has, which is the same
+        if (!changed) return false;
+        frame.Version = ++frameVersion;
+        frames->Publish();
+        return true;
+    }
+
+    const FrameSnapshot& Game::GetLatestFrame() {
+        return frames->GetFront();
+    }
+
+    bool Game::RequestRedraw(bool frameChanged) {
+        if (frameChanged) {
+            redrawsRequested++;
+            if (redrawWanted) redrawsCoalesced++; // still waiting from an earlier frame
+            redrawWanted = true;
+        } else {
+            framesUnchanged++;
+        }
+        if (!redrawWanted) return false;
+
+        //  Keep to the maximum frame rate, and to one redraw in the UI queue at a time
+        auto now = std::chrono::steady_clock::now();
+        int maxFps = options->MaxFramesPerSecond;
+        if (maxFps > 0 && now - lastRedrawRequest < std::chrono::microseconds(1000000 / maxFps)) return false;
+        if (framePending.exchange(true)) return false;
+        lastRedrawRequest = now;
+        redrawWanted = false;
+        return true;
+    }
+
+    void Game::MarkFrameDrawn(bool reused) {
+        framePending = false;
+        if (reused) framesReused++;
+        else framesDrawn++;
+    }
+
+    util::LatencyHistogram& Game::GetHandlerProfile(ProfiledHandler handler) {
+        return handlerProfiles[static_cast<int>(handler)];
+    }
+
+    bool Game::WriteHandlerProfiles(const std::string& path) {
+        std::ofstream profileStream(path, std::ofstream::out | std::ofstream::trunc);
+        if (!profileStream.is_open()) return false;
+        profileStream << "{\n  \"tick_budget_us\": " << TICK_MICROS << ",\n  \"handlers\": [";
+        for (int i = 0; i < static_cast<int>(ProfiledHandler::COUNT); i++) {
+            auto handler = static_cast<ProfiledHandler>(i);
+            const auto& profile = GetHandlerProfile(handler);
+            profileStream << (i > 0 ? ",\n" : "\n") << "    {\"name\": \"" << GetProfiledHandlerName(handler) << "\""
+                << ", \"count\": " << profile.GetCount() << ", \"mean_us\": " << profile.GetMean()
+                << ", \"p50_us\": " << profile.GetPercentile(50) << ", \"p99_us\": " << profile.GetPercentile(99)
+                << ", \"max_us\": " << profile.GetMax() << "}";
+        }
+        profileStream << "\n  ]\n}\n";
+        return profileStream.good();
+    }
+
+    RedrawStats Game::GetRedrawStats() {
+        RedrawStats stats;
+        stats.Requested = redrawsRequested.load();
+        stats.Coalesced = redrawsCoalesced.load();
+        stats.Unchanged = framesUnchanged.load();
+        stats.Drawn = framesDrawn.load();
+        stats.Reused = framesReused.load();
+        return stats;
+    }
+
 } // namespace core
\ No newline at end of file
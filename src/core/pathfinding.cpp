@@ -0,0 +1,830 @@
+#include <core/pathfinding.hpp>
+#include <core/entity_type.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+
+namespace core {
+
+    //  The 8 neighbour offsets. Orthogonal moves come first so that they are
+    //  preferred over diagonal ones when distances are equal.
+    static const int NEIGHBOUR_DX[8] = { 0, -1, 1, 0, -1, 1, -1, 1 };
+    static const int NEIGHBOUR_DY[8] = { -1, 0, 0, 1, -1, -1, 1, 1 };
+
+    //  Returns true if (x, y) is inside the arena and not on its outermost layer.
+    inline static bool isInner(int x, int y) {
+        return x >= 1 && x < ARENA_WIDTH - 1 && y >= 1 && y < ARENA_HEIGHT - 1;
+    }
+
+    //  Returns the manhattan distance between two cells.
+    inline static int heuristic(int ax, int ay, int bx, int by) {
+        return std::abs(ax - bx) + std::abs(ay - by);
+    }
+
+    //  BEGIN: FlowField
+
+    FlowField::FlowField() {
+        std::fill(distance, distance + ARENA_HEIGHT * ARENA_WIDTH, UNREACHABLE);
+    }
+
+    void FlowField::Compute(const OccupancySnapshot& snapshot, const std::vector<Point>& sources) {
+        std::fill(distance, distance + ARENA_HEIGHT * ARENA_WIDTH, UNREACHABLE);
+        this->sources = sources;
+
+        int head = 0, tail = 0;
+        for (auto source : sources) {
+            if (!isInner(source.x, source.y)) continue;
+            int index = source.y * ARENA_WIDTH + source.x;
+            if (distance[index] == 0) continue; // duplicated source
+            distance[index] = 0;
+            queue[tail++] = index;
+        }
+
+        while (head < tail) {
+            int current = queue[head++];
+            int cx = current % ARENA_WIDTH, cy = current / ARENA_WIDTH;
+            for (int i = 0; i < 8; i++) {
+                int nx = cx + NEIGHBOUR_DX[i], ny = cy + NEIGHBOUR_DY[i];
+                if (!isInner(nx, ny)) continue;
+                int next = ny * ARENA_WIDTH + nx;
+                if (distance[next] != UNREACHABLE) continue; // already visited
+                if (snapshot.Types[ny][nx] == EntityType::WALL) continue;
+                distance[next] = distance[current] + 1;
+                queue[tail++] = next;
+            }
+        }
+    }
+
+    bool FlowField::IsComputedFrom(const std::vector<Point>& sources) const {
+        return this->sources == sources;
+    }
+
+    int FlowField::GetDistance(Point p) const {
+        if (p.x < 0 || p.x >= ARENA_WIDTH || p.y < 0 || p.y >= ARENA_HEIGHT) return UNREACHABLE;
+        return distance[p.y * ARENA_WIDTH + p.x];
+    }
+
+    Point FlowField::NextStep(Point from, const OccupancySnapshot& snapshot) const {
+        const unsigned int enterable = TypeBit(EntityType::AIR) | TypeBit(EntityType::PLAYER) | TypeBit(EntityType::ABSTRACT_COLLECTIBLE);
+        int bestDistance = GetDistance(from);
+        Point best = from;
+        for (int i = 0; i < 8; i++) {
+            int nx = from.x + NEIGHBOUR_DX[i], ny = from.y + NEIGHBOUR_DY[i];
+            if (!isInner(nx, ny)) continue;
+            int d = distance[ny * ARENA_WIDTH + nx];
+            if (d == UNREACHABLE) continue;
+            if (bestDistance != UNREACHABLE && d >= bestDistance) continue;
+            if (!(TypeAncestry(snapshot.Types[ny][nx]) & enterable)) continue; // blocked by a mob or bullet
+            bestDistance = d;
+            best = {nx, ny};
+        }
+        return best;
+    }
+
+    //  END: FlowField
+
+    //  Returns true if a mob can walk through (x, y), i.e. it is an inner cell that
+    //  is neither a wall nor another mob.
+    inline static bool isWalkable(const OccupancySnapshot& snapshot, int x, int y) {
+        const unsigned int blocked = TypeBit(EntityType::WALL) | TypeBit(EntityType::ABSTRACT_MOB);
+        return isInner(x, y) && !(TypeAncestry(snapshot.Types[y][x]) & blocked);
+    }
+
+    //  Returns true if the point is inside the arena.
+    inline static bool isInside(Point p) {
+        return p.x >= 0 && p.x < ARENA_WIDTH && p.y >= 0 && p.y < ARENA_HEIGHT;
+    }
+
+    //  Returns the sign of v (-1, 0 or 1).
+    inline static int sign(int v) {
+        return (v > 0) - (v < 0);
+    }
+
+    //  BEGIN: Pathfinder
+
+    Pathfinder::Pathfinder() {
+        std::fill(stamp, stamp + ARENA_HEIGHT * ARENA_WIDTH, 0u);
+        open.reserve(ARENA_HEIGHT * ARENA_WIDTH);
+    }
+
+    int Pathfinder::GetLastExpansions() const {
+        return lastExpansions;
+    }
+
+    bool Pathfinder::WasLastQueryIncremental() const {
+        return false;
+    }
+
+    void Pathfinder::beginQuery(int startIndex) {
+        if (++generation == 0) {
+            // the stamp wrapped around, stale stamps could now look current
+            std::fill(stamp, stamp + ARENA_HEIGHT * ARENA_WIDTH, 0u);
+            generation = 1;
+        }
+        lastExpansions = 0;
+        open.clear();
+        open.emplace_back(0, startIndex);
+        stamp[startIndex] = generation;
+        cost[startIndex] = 0;
+        cameFrom[startIndex] = startIndex;
+    }
+
+    void Pathfinder::relax(int current, int next, int newCost, int priority) {
+        if (stamp[next] == generation && newCost >= cost[next]) return;
+        stamp[next] = generation;
+        cost[next] = newCost;
+        cameFrom[next] = current;
+        open.emplace_back(priority, next);
+        std::push_heap(open.begin(), open.end(), std::greater<Node>());
+    }
+
+    int Pathfinder::popOpen() {
+        std::pop_heap(open.begin(), open.end(), std::greater<Node>());
+        int current = open.back().second;
+        open.pop_back();
+        return current;
+    }
+
+    std::list<Point> Pathfinder::reconstructPath(int startIndex, int endIndex) const {
+        std::list<Point> path;
+        if (stamp[endIndex] != generation) return path; // No path found
+        int current = endIndex; // include end point (player position) in path for collision
+        while (current != startIndex) {
+            int previous = cameFrom[current];
+            int cx = current % ARENA_WIDTH, cy = current / ARENA_WIDTH;
+            int px = previous % ARENA_WIDTH, py = previous / ARENA_WIDTH;
+            int dx = sign(px - cx), dy = sign(py - cy);
+            while (cx != px || cy != py) {
+                path.push_front({cx, cy});
+                cx += dx;
+                cy += dy;
+            }
+            current = previous;
+        }
+        return path;
+    }
+
+    //  END: Pathfinder
+
+    //  BEGIN: AStarPathfinder
+
+    std::list<Point> AStarPathfinder::FindPath(const OccupancySnapshot& snapshot, Point start, Point end) {
+        // References:
+        // - https://www.redblobgames.com/pathfinding/a-star/introduction.html
+        // - https://www.redblobgames.com/pathfinding/a-star/implementation.html#cpp-astar
+        lastExpansions = 0;
+        if (!isInside(start) || !isInside(end)) return {};
+        int startIndex = start.y * ARENA_WIDTH + start.x;
+        int endIndex = end.y * ARENA_WIDTH + end.x;
+        beginQuery(startIndex);
+
+        while (!open.empty()) {
+            int current = popOpen();
+            if (current == endIndex) break;
+            lastExpansions++;
+
+            int cx = current % ARENA_WIDTH, cy = current / ARENA_WIDTH;
+            for (int i = 0; i < 8; i++) {
+                int nx = cx + NEIGHBOUR_DX[i], ny = cy + NEIGHBOUR_DY[i];
+                if (!isWalkable(snapshot, nx, ny)) continue; // Skip walls and other mobs
+                int newCost = cost[current] + 1;
+                relax(current, ny * ARENA_WIDTH + nx, newCost, newCost + heuristic(nx, ny, end.x, end.y));
+            }
+        }
+
+        return reconstructPath(startIndex, endIndex);
+    }
+
+    bool AStarPathfinder::WasReached(Point p) const {
+        return isInside(p) && stamp[p.y * ARENA_WIDTH + p.x] == generation;
+    }
+
+    //  END: AStarPathfinder
+
+    //  BEGIN: JumpPointPathfinder
+
+    std::list<Point> JumpPointPathfinder::FindPath(const OccupancySnapshot& snapshot, Point start, Point end) {
+        // References:
+        // - D. Harabor and A. Grastien, "Online Graph Pruning for Pathfinding on Grid Maps", AAAI 2011.
+        // - https://github.com/qiao/PathFinding.js (JumpPointFinderBase, diagonal movement always allowed)
+        lastExpansions = 0;
+        if (!isInside(start) || !isInside(end)) return {};
+        int startIndex = start.y * ARENA_WIDTH + start.x;
+        int endIndex = end.y * ARENA_WIDTH + end.x;
+        beginQuery(startIndex);
+
+        int directions[8][2];
+        while (!open.empty()) {
+            int current = popOpen();
+            if (current == endIndex) break;
+            lastExpansions++;
+
+            int x = current % ARENA_WIDTH, y = current / ARENA_WIDTH;
+            int count = 0;
+            if (current == startIndex) {
+                // the start has no parent, search every direction
+                for (int i = 0; i < 8; i++) {
+                    directions[count][0] = NEIGHBOUR_DX[i];
+                    directions[count++][1] = NEIGHBOUR_DY[i];
+                }
+            } else {
+                // prune the neighbours that are reached at least as cheaply without passing this cell
+                int parent = cameFrom[current];
+                int dx = sign(x - parent % ARENA_WIDTH), dy = sign(y - parent / ARENA_WIDTH);
+                if (dx != 0 && dy != 0) {
+                    directions[count][0] = 0;   directions[count++][1] = dy;
+                    directions[count][0] = dx;  directions[count++][1] = 0;
+                    directions[count][0] = dx;  directions[count++][1] = dy;
+                    if (!isWalkable(snapshot, x - dx, y)) { directions[count][0] = -dx; directions[count++][1] = dy; }
+                    if (!isWalkable(snapshot, x, y - dy)) { directions[count][0] = dx; directions[count++][1] = -dy; }
+                } else if (dx != 0) {
+                    directions[count][0] = dx;  directions[count++][1] = 0;
+                    if (!isWalkable(snapshot, x, y + 1)) { directions[count][0] = dx; directions[count++][1] = 1; }
+                    if (!isWalkable(snapshot, x, y - 1)) { directions[count][0] = dx; directions[count++][1] = -1; }
+                } else {
+                    directions[count][0] = 0;   directions[count++][1] = dy;
+                    if (!isWalkable(snapshot, x + 1, y)) { directions[count][0] = 1; directions[count++][1] = dy; }
+                    if (!isWalkable(snapshot, x - 1, y)) { directions[count][0] = -1; directions[count++][1] = dy; }
+                }
+            }
+
+            for (int i = 0; i < count; i++) {
+                int jumpPoint = jump(snapshot, x + directions[i][0], y + directions[i][1], directions[i][0], directions[i][1], end);
+                if (jumpPoint < 0) continue;
+                int jx = jumpPoint % ARENA_WIDTH, jy = jumpPoint / ARENA_WIDTH;
+                // moves cost 1 in every direction, so the distance along a line is the chebyshev distance
+                int newCost = cost[current] + std::max(std::abs(jx - x), std::abs(jy - y));
+                relax(current, jumpPoint, newCost, newCost + std::max(std::abs(jx - end.x), std::abs(jy - end.y)));
+            }
+        }
+
+        return reconstructPath(startIndex, endIndex);
+    }
+
+    int JumpPointPathfinder::jump(const OccupancySnapshot& snapshot, int x, int y, int dx, int dy, Point end) const {
+        while (true) {
+            bool atEnd = x == end.x && y == end.y;
+            if (atEnd) return y * ARENA_WIDTH + x; // the end (the player) is never an obstacle
+            if (!isWalkable(snapshot, x, y)) return -1;
+
+            if (dx != 0 && dy != 0) {
+                // diagonal: stop at forced neighbours, or where a straight jump finds something
+                if ((isWalkable(snapshot, x - dx, y + dy) && !isWalkable(snapshot, x - dx, y))
+                    || (isWalkable(snapshot, x + dx, y - dy) && !isWalkable(snapshot, x, y - dy))) {
+                    return y * ARENA_WIDTH + x;
+                }
+                if (jump(snapshot, x + dx, y, dx, 0, end) >= 0 || jump(snapshot, x, y + dy, 0, dy, end) >= 0) {
+                    return y * ARENA_WIDTH + x;
+                }
+            } else if (dx != 0) {
+                // horizontal
+                if ((isWalkable(snapshot, x + dx, y + 1) && !isWalkable(snapshot, x, y + 1))
+                    || (isWalkable(snapshot, x + dx, y - 1) && !isWalkable(snapshot, x, y - 1))) {
+                    return y * ARENA_WIDTH + x;
+                }
+            } else {
+                // vertical
+                if ((isWalkable(snapshot, x + 1, y + dy) && !isWalkable(snapshot, x + 1, y))
+                    || (isWalkable(snapshot, x - 1, y + dy) && !isWalkable(snapshot, x - 1, y))) {
+                    return y * ARENA_WIDTH + x;
+                }
+            }
+            x += dx;
+            y += dy;
+        }
+    }
+
+    //  END: JumpPointPathfinder
+
+    //  BEGIN: ClusterGraph
+
+    ClusterGraph::ClusterGraph(const OccupancySnapshot& snapshot) {
+        for (int y = 0; y < ARENA_HEIGHT; y++) {
+            for (int x = 0; x < ARENA_WIDTH; x++) {
+                walls[y][x] = !isInner(x, y) || snapshot.Types[y][x] == EntityType::WALL;
+            }
+        }
+        clustersPerRow = (ARENA_WIDTH + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+        int clustersPerColumn = (ARENA_HEIGHT + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+        clusterNodes.assign(clustersPerRow * clustersPerColumn, {});
+        edges.assign(ARENA_HEIGHT * ARENA_WIDTH, {});
+
+        //  Entrances between horizontally and vertically neighbouring clusters
+        for (int cy = 0; cy < clustersPerColumn; cy++) {
+            int top = cy * CLUSTER_SIZE;
+            int height = std::min(CLUSTER_SIZE, ARENA_HEIGHT - top);
+            for (int cx = 0; cx < clustersPerRow; cx++) {
+                int left = cx * CLUSTER_SIZE;
+                int width = std::min(CLUSTER_SIZE, ARENA_WIDTH - left);
+                if (left + width < ARENA_WIDTH) { // border with the cluster on the right
+                    addEntrances(left + width - 1, top, left + width, top, 0, 1, height);
+                }
+                if (top + height < ARENA_HEIGHT) { // border with the cluster below
+                    addEntrances(left, top + height - 1, left, top + height, 1, 0, width);
+                }
+            }
+        }
+
+        //  Edges between the nodes of each cluster, weighted by their distance inside the cluster
+        std::vector<int> distance(ARENA_HEIGHT * ARENA_WIDTH, -1);
+        for (auto& nodes : clusterNodes) {
+            for (int from : nodes) {
+                ComputeClusterDistances({from % ARENA_WIDTH, from / ARENA_WIDTH}, distance);
+                for (int to : nodes) {
+                    if (to != from && distance[to] > 0) addEdge(from, to, distance[to]);
+                }
+            }
+        }
+    }
+
+    int ClusterGraph::GetClusterOf(Point p) const {
+        return (p.y / CLUSTER_SIZE) * clustersPerRow + p.x / CLUSTER_SIZE;
+    }
+
+    int ClusterGraph::GetClusterOf(int cell) const {
+        return GetClusterOf({cell % ARENA_WIDTH, cell / ARENA_WIDTH});
+    }
+
+    const std::vector<int>& ClusterGraph::GetNodesInCluster(int cluster) const {
+        return clusterNodes[cluster];
+    }
+
+    const std::vector<ClusterGraph::Edge>& ClusterGraph::GetEdges(int cell) const {
+        return edges[cell];
+    }
+
+    int ClusterGraph::GetNodeCount() const {
+        return nodeCount;
+    }
+
+    void ClusterGraph::ComputeClusterDistances(Point p, std::vector<int>& distance) const {
+        int left = (p.x / CLUSTER_SIZE) * CLUSTER_SIZE, top = (p.y / CLUSTER_SIZE) * CLUSTER_SIZE;
+        int right = std::min(left + CLUSTER_SIZE, ARENA_WIDTH), bottom = std::min(top + CLUSTER_SIZE, ARENA_HEIGHT);
+        for (int y = top; y < bottom; y++) {
+            for (int x = left; x < right; x++) distance[y * ARENA_WIDTH + x] = -1;
+        }
+        if (walls[p.y][p.x]) return;
+
+        int queue[CLUSTER_SIZE * CLUSTER_SIZE];
+        int head = 0, tail = 0;
+        distance[p.y * ARENA_WIDTH + p.x] = 0;
+        queue[tail++] = p.y * ARENA_WIDTH + p.x;
+        while (head < tail) {
+            int current = queue[head++];
+            int cx = current % ARENA_WIDTH, cy = current / ARENA_WIDTH;
+            for (int i = 0; i < 8; i++) {
+                int nx = cx + NEIGHBOUR_DX[i], ny = cy + NEIGHBOUR_DY[i];
+                if (nx < left || nx >= right || ny < top || ny >= bottom) continue;
+                int next = ny * ARENA_WIDTH + nx;
+                if (walls[ny][nx] || distance[next] != -1) continue;
+                distance[next] = distance[current] + 1;
+                queue[tail++] = next;
+            }
+        }
+    }
+
+    void ClusterGraph::addEntrances(int ax, int ay, int bx, int by, int dx, int dy, int length) {
+        //  Every maximal run of cells that are open on both sides of the border is one entrance.
+        //  Short entrances get one transition in the middle, long ones get one at each end.
+        int runStart = -1;
+        for (int i = 0; i <= length; i++) {
+            bool open = i < length
+                && !walls[ay + dy * i][ax + dx * i]
+                && !walls[by + dy * i][bx + dx * i];
+            if (open && runStart < 0) runStart = i;
+            if (open || runStart < 0) continue;
+
+            int runEnd = i - 1;
+            int transitions[2] = {(runStart + runEnd) / 2, -1};
+            if (runEnd - runStart + 1 >= 6) {
+                transitions[0] = runStart;
+                transitions[1] = runEnd;
+            }
+            for (int t : transitions) {
+                if (t < 0) continue;
+                int a = (ay + dy * t) * ARENA_WIDTH + (ax + dx * t);
+                int b = (by + dy * t) * ARENA_WIDTH + (bx + dx * t);
+                addNode(a);
+                addNode(b);
+                addEdge(a, b, 1);
+                addEdge(b, a, 1);
+            }
+            runStart = -1;
+        }
+    }
+
+    void ClusterGraph::addNode(int cell) {
+        auto& nodes = clusterNodes[GetClusterOf(cell)];
+        if (std::find(nodes.begin(), nodes.end(), cell) != nodes.end()) return;
+        nodes.push_back(cell);
+        nodeCount++;
+    }
+
+    void ClusterGraph::addEdge(int from, int to, int cost) {
+        for (auto& edge : edges[from]) {
+            if (edge.To == to) {
+                edge.Cost = std::min(edge.Cost, cost);
+                return;
+            }
+        }
+        edges[from].push_back({to, cost});
+    }
+
+    //  END: ClusterGraph
+
+    //  BEGIN: HierarchicalPathfinder
+
+    HierarchicalPathfinder::HierarchicalPathfinder(const ClusterGraph* graph)
+        : graph(graph), startDistance(ARENA_HEIGHT * ARENA_WIDTH, -1), endDistance(ARENA_HEIGHT * ARENA_WIDTH, -1) { }
+
+    std::list<Point> HierarchicalPathfinder::FindPath(const OccupancySnapshot& snapshot, Point start, Point end) {
+        lastExpansions = 0;
+        if (!isInside(start) || !isInside(end)) return {};
+        if (graph == nullptr || graph->GetClusterOf(start) == graph->GetClusterOf(end)) {
+            auto path = refiner.FindPath(snapshot, start, end);
+            lastExpansions = refiner.GetLastExpansions();
+            return path;
+        }
+
+        //  Link the start and the end to the entrances of their clusters
+        int startIndex = start.y * ARENA_WIDTH + start.x;
+        int endIndex = end.y * ARENA_WIDTH + end.x;
+        int startCluster = graph->GetClusterOf(startIndex), endCluster = graph->GetClusterOf(endIndex);
+        graph->ComputeClusterDistances(start, startDistance);
+        graph->ComputeClusterDistances(end, endDistance);
+
+        //  Search the abstract graph. Nodes are cells, so the cell-indexed buffers are reused.
+        beginQuery(startIndex);
+        while (!open.empty()) {
+            int current = popOpen();
+            if (current == endIndex) break;
+            lastExpansions++;
+
+            auto visit = [&](int next, int edgeCost) {
+                int nx = next % ARENA_WIDTH, ny = next / ARENA_WIDTH;
+                int newCost = cost[current] + edgeCost;
+                relax(current, next, newCost, newCost + std::max(std::abs(nx - end.x), std::abs(ny - end.y)));
+            };
+            if (current == startIndex) {
+                for (int node : graph->GetNodesInCluster(startCluster)) {
+                    if (startDistance[node] > 0) visit(node, startDistance[node]);
+                }
+            }
+            for (auto& edge : graph->GetEdges(current)) visit(edge.To, edge.Cost); // empty unless current is a node
+            if (graph->GetClusterOf(current) == endCluster && endDistance[current] >= 0) {
+                visit(endIndex, endDistance[current]);
+            }
+        }
+
+        //  Refine the first hop: from the start to the first node outside the start cluster.
+        int waypoint = -1;
+        if (stamp[endIndex] == generation) {
+            for (int node = endIndex; node != startIndex; node = cameFrom[node]) {
+                if (graph->GetClusterOf(node) != startCluster) waypoint = node;
+            }
+        }
+        //  A waypoint taken by a mob cannot be reached, so it is not refined.
+        std::list<Point> path;
+        bool refined = waypoint >= 0 && isWalkable(snapshot, waypoint % ARENA_WIDTH, waypoint / ARENA_WIDTH);
+        if (refined) {
+            path = refiner.FindPath(snapshot, start, {waypoint % ARENA_WIDTH, waypoint / ARENA_WIDTH});
+            lastExpansions += refiner.GetLastExpansions();
+        }
+        if (path.empty()) {
+            //  A failed refinement has searched everything reachable from the start. If that
+            //  did not include the end, e.g. when mobs surround the player, neither would a
+            //  search of the whole grid.
+            if (refined && !refiner.WasReached(end)) return path;
+            //  The abstract route is blocked (e.g. by mobs) or missing, search the whole grid instead
+            path = refiner.FindPath(snapshot, start, end);
+            lastExpansions += refiner.GetLastExpansions();
+        }
+        return path;
+    }
+
+    //  END: HierarchicalPathfinder
+
+    //  BEGIN: DStarLitePathfinder
+
+    //  g and rhs of cells that cannot reach the root.
+    static const int INFINITE_COST = 1 << 20;
+    //  k1 is packed above k2 in a key; k2 is a path length, which stays below this.
+    static const int KEY_SCALE = 1 << 12;
+
+    //  Returns the chebyshev distance between two cells, given by index.
+    inline static int cellDistance(int a, int b) {
+        return std::max(std::abs(a % ARENA_WIDTH - b % ARENA_WIDTH), std::abs(a / ARENA_WIDTH - b / ARENA_WIDTH));
+    }
+
+    std::list<Point> DStarLitePathfinder::FindPath(const OccupancySnapshot& snapshot, Point start, Point end) {
+        // References:
+        // - S. Koenig and M. Likhachev, "D* Lite", AAAI 2002 (the optimised version, Fig. 4)
+        // The roles are swapped compared to the paper: the tree is rooted at the mob (the paper's goal)
+        // and searches towards the player (the paper's start), since the player moves far more often.
+        lastExpansions = 0;
+        if (!isInside(start) || !isInside(end)) return {};
+        int startIndex = start.y * ARENA_WIDTH + start.x;
+        int endIndex = end.y * ARENA_WIDTH + end.x;
+
+        lastQueryIncremental = generation != 0 && startIndex == rootIndex && keyModifier < MAX_KEY_MODIFIER;
+        if (!lastQueryIncremental) {
+            beginQuery(startIndex);
+            open.clear();
+            rootIndex = startIndex;
+            targetIndex = endIndex;
+            keyModifier = 0;
+            last = snapshot;
+            cost[rootIndex] = INFINITE_COST;
+            rhs[rootIndex] = 0;
+            queuedKey[rootIndex] = calculateKey(rootIndex);
+            open.emplace_back(queuedKey[rootIndex], rootIndex);
+        } else {
+            if (endIndex != targetIndex) {
+                keyModifier += cellDistance(targetIndex, endIndex);
+                targetIndex = endIndex;
+            }
+            //  Repair around the cells whose walkability changed since the last query.
+            //  Only the rows the arena changed since then can hold such cells.
+            for (int y = 1; y < ARENA_HEIGHT - 1; y++) {
+                if (last.RowVersion[y] == snapshot.RowVersion[y]) continue;
+                for (int x = 1; x < ARENA_WIDTH - 1; x++) {
+                    if (last.Types[y][x] == snapshot.Types[y][x]) continue;
+                    int cell = y * ARENA_WIDTH + x;
+                    if (isOpenCell(last, cell) == isOpenCell(snapshot, cell)) continue;
+                    updateVertex(snapshot, cell);
+                    for (int i = 0; i < 8; i++) {
+                        int nx = x + NEIGHBOUR_DX[i], ny = y + NEIGHBOUR_DY[i];
+                        if (isInner(nx, ny)) updateVertex(snapshot, ny * ARENA_WIDTH + nx);
+                    }
+                }
+                std::copy(snapshot.Types[y], snapshot.Types[y] + ARENA_WIDTH, last.Types[y]);
+                last.RowVersion[y] = snapshot.RowVersion[y];
+            }
+        }
+        computeShortestPath(snapshot);
+
+        //  Walk down g from the target to the root; the walk is the path in reverse.
+        std::list<Point> path;
+        touch(targetIndex);
+        if (rhs[targetIndex] >= INFINITE_COST) return path; // No path found, g of the target itself may be stale
+        int current = targetIndex;
+        while (current != rootIndex) {
+            path.push_front({current % ARENA_WIDTH, current / ARENA_WIDTH});
+            if ((int) path.size() > ARENA_HEIGHT * ARENA_WIDTH) return {}; // g is inconsistent, should not happen
+            int cx = current % ARENA_WIDTH, cy = current / ARENA_WIDTH;
+            int best = -1, bestCost = INFINITE_COST;
+            for (int i = 0; i < 8; i++) {
+                int nx = cx + NEIGHBOUR_DX[i], ny = cy + NEIGHBOUR_DY[i];
+                int next = ny * ARENA_WIDTH + nx;
+                if (!isInner(nx, ny) || !isOpenCell(snapshot, next)) continue;
+                touch(next);
+                if (cost[next] < bestCost) {
+                    bestCost = cost[next];
+                    best = next;
+                }
+            }
+            if (best < 0) return {};
+            current = best;
+        }
+        return path;
+    }
+
+    bool DStarLitePathfinder::WasLastQueryIncremental() const {
+        return lastQueryIncremental;
+    }
+
+    bool DStarLitePathfinder::isOpenCell(const OccupancySnapshot& snapshot, int cell) const {
+        // the root is the mob this search belongs to, so it does not block itself
+        return cell == rootIndex || isWalkable(snapshot, cell % ARENA_WIDTH, cell / ARENA_WIDTH);
+    }
+
+    void DStarLitePathfinder::touch(int cell) {
+        if (stamp[cell] == generation) return;
+        stamp[cell] = generation;
+        cost[cell] = INFINITE_COST;
+        rhs[cell] = INFINITE_COST;
+        queuedKey[cell] = -1;
+    }
+
+    int DStarLitePathfinder::calculateKey(int cell) const {
+        int g = std::min(cost[cell], rhs[cell]);
+        if (g >= INFINITE_COST) return std::numeric_limits<int>::max();
+        return (g + cellDistance(targetIndex, cell) + keyModifier) * KEY_SCALE + g;
+    }
+
+    void DStarLitePathfinder::updateVertex(const OccupancySnapshot& snapshot, int cell) {
+        touch(cell);
+        if (cell != rootIndex) {
+            rhs[cell] = INFINITE_COST;
+            if (isOpenCell(snapshot, cell)) {
+                int cx = cell % ARENA_WIDTH, cy = cell / ARENA_WIDTH;
+                for (int i = 0; i < 8; i++) {
+                    int nx = cx + NEIGHBOUR_DX[i], ny = cy + NEIGHBOUR_DY[i];
+                    int next = ny * ARENA_WIDTH + nx;
+                    if (!isInner(nx, ny) || !isOpenCell(snapshot, next)) continue;
+                    touch(next);
+                    rhs[cell] = std::min(rhs[cell], cost[next] + 1);
+                }
+            }
+        }
+        if (cost[cell] != rhs[cell]) {
+            queuedKey[cell] = calculateKey(cell);
+            open.emplace_back(queuedKey[cell], cell);
+            std::push_heap(open.begin(), open.end(), std::greater<Node>());
+        } else {
+            queuedKey[cell] = -1;
+        }
+    }
+
+    void DStarLitePathfinder::computeShortestPath(const OccupancySnapshot& snapshot) {
+        touch(targetIndex);
+        while (!open.empty()) {
+            Node top = open.front();
+            if (stamp[top.second] != generation || queuedKey[top.second] != top.first) {
+                popOpen(); // stale entry
+                continue;
+            }
+            if (top.first >= calculateKey(targetIndex) && rhs[targetIndex] <= cost[targetIndex]) break;
+
+            int current = popOpen();
+            queuedKey[current] = -1;
+            lastExpansions++;
+            int newKey = calculateKey(current);
+            if (top.first < newKey) {
+                queuedKey[current] = newKey;
+                open.emplace_back(newKey, current);
+                std::push_heap(open.begin(), open.end(), std::greater<Node>());
+                continue;
+            }
+
+            if (cost[current] > rhs[current]) {
+                cost[current] = rhs[current];
+            } else {
+                cost[current] = INFINITE_COST;
+                updateVertex(snapshot, current);
+            }
+            int cx = current % ARENA_WIDTH, cy = current / ARENA_WIDTH;
+            for (int i = 0; i < 8; i++) {
+                int nx = cx + NEIGHBOUR_DX[i], ny = cy + NEIGHBOUR_DY[i];
+                if (isInner(nx, ny)) updateVertex(snapshot, ny * ARENA_WIDTH + nx);
+            }
+        }
+    }
+
+    //  END: DStarLitePathfinder
+
+    //  BEGIN: ReservationTable
+
+    ReservationTable::ReservationTable() : reservations(ARENA_HEIGHT * ARENA_WIDTH) { }
+
+    bool ReservationTable::IsFree(int cell, long long from, long long to, int mobId) const {
+        for (auto& reservation : reservations[cell]) {
+            if (reservation.MobId == mobId) continue;
+            if (reservation.From <= to && from <= reservation.To) return false;
+        }
+        return true;
+    }
+
+    void ReservationTable::Reserve(int cell, long long from, long long to, int mobId) {
+        reservations[cell].push_back({from, to, mobId});
+        cellsByMob[mobId].push_back(cell);
+    }
+
+    void ReservationTable::Release(int mobId) {
+        auto cells = cellsByMob.find(mobId);
+        if (cells == cellsByMob.end()) return;
+        for (int cell : cells->second) {
+            auto& list = reservations[cell];
+            list.erase(std::remove_if(list.begin(), list.end(),
+                [mobId](const Reservation& reservation) { return reservation.MobId == mobId; }), list.end());
+        }
+        cellsByMob.erase(cells);
+    }
+
+    void ReservationTable::Prune(long long now) {
+        for (auto& list : reservations) {
+            list.erase(std::remove_if(list.begin(), list.end(),
+                [now](const Reservation& reservation) { return reservation.To < now; }), list.end());
+        }
+    }
+
+    //  END: ReservationTable
+
+    //  BEGIN: CooperativePlanner
+
+    CooperativePlanner::CooperativePlanner()
+        : cost(ARENA_HEIGHT * ARENA_WIDTH * (WINDOW + 1)), cameFrom(ARENA_HEIGHT * ARENA_WIDTH * (WINDOW + 1)),
+          stamp(ARENA_HEIGHT * ARENA_WIDTH * (WINDOW + 1), 0u) {
+        open.reserve(ARENA_HEIGHT * ARENA_WIDTH);
+    }
+
+    int CooperativePlanner::GetLastExpansions() const {
+        return lastExpansions;
+    }
+
+    std::list<Point> CooperativePlanner::PlanPath(const OccupancySnapshot& snapshot, const FlowField& field, ReservationTable& table,
+        int mobId, Point start, Point end, long long now, long long firstStepTick, int ticksPerStep) {
+        // References:
+        // - D. Silver, "Cooperative Pathfinding", AIIDE 2005 (windowed hierarchical cooperative A*)
+        const int cells = ARENA_HEIGHT * ARENA_WIDTH;
+        // the tick the mob arrives at its k-th step; it stays there until the next one
+        auto stepTick = [&](int k) { return k == 0 ? now : firstStepTick + (long long) (k - 1) * ticksPerStep; };
+
+        lastExpansions = 0;
+        table.Release(mobId);
+        if (!isInside(start) || !isInside(end) || field.GetDistance(start) == FlowField::UNREACHABLE) return {};
+        int startIndex = start.y * ARENA_WIDTH + start.x;
+        int endIndex = end.y * ARENA_WIDTH + end.x;
+        if (++generation == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0u);
+            generation = 1;
+        }
+        open.clear();
+        open.emplace_back(field.GetDistance(start), startIndex);
+        stamp[startIndex] = generation;
+        cost[startIndex] = 0;
+        cameFrom[startIndex] = startIndex;
+
+        int goal = -1;
+        while (!open.empty()) {
+            std::pop_heap(open.begin(), open.end(), std::greater<Node>());
+            Node top = open.back();
+            open.pop_back();
+            int state = top.second, cell = state % cells, step = state / cells;
+            int cx = cell % ARENA_WIDTH, cy = cell / ARENA_WIDTH;
+            if (top.first > cost[state] + field.GetDistance({cx, cy})) continue; // stale entry
+            if (cell == endIndex || step == WINDOW) {
+                goal = state;
+                break;
+            }
+            lastExpansions++;
+
+            for (int i = 0; i <= 8; i++) { // the 8 moves, then waiting in place
+                int nx = i < 8 ? cx + NEIGHBOUR_DX[i] : cx, ny = i < 8 ? cy + NEIGHBOUR_DY[i] : cy;
+                int next = ny * ARENA_WIDTH + nx;
+                if (!isInner(nx, ny)) continue;
+                int distance = field.GetDistance({nx, ny});
+                if (distance == FlowField::UNREACHABLE) continue; // walls are never reachable
+                if (next != endIndex) {
+                    // other mobs are only known to be in place for the first step, beyond that
+                    // they are expected to follow their reservations
+                    if (step == 0 && next != startIndex && !isWalkable(snapshot, nx, ny)) continue;
+                    if (!table.IsFree(next, stepTick(step + 1), stepTick(step + 2), mobId)) continue;
+                }
+                int nextState = (step + 1) * cells + next;
+                int newCost = cost[state] + 1;
+                if (stamp[nextState] == generation && newCost >= cost[nextState]) continue;
+                stamp[nextState] = generation;
+                cost[nextState] = newCost;
+                cameFrom[nextState] = state;
+                open.emplace_back(newCost + distance, nextState);
+                std::push_heap(open.begin(), open.end(), std::greater<Node>());
+            }
+        }
+        if (goal < 0) return {}; // No path found
+
+        std::list<Point> path;
+        for (int state = goal; state != startIndex; state = cameFrom[state]) {
+            int cell = state % cells;
+            path.push_front({cell % ARENA_WIDTH, cell / ARENA_WIDTH});
+        }
+
+        //  Reserve the window. The mob stays in its last cell before the end for as long as it
+        //  attacks, so that cell is held for another window.
+        int lastStep = goal / cells;
+        bool reachedEnd = goal % cells == endIndex;
+        int step = 0;
+        int cell = startIndex;
+        for (auto it = path.begin(); cell != endIndex; step++) {
+            long long until = stepTick(step + 1);
+            if (reachedEnd && step == lastStep - 1) until += (long long) WINDOW * ticksPerStep;
+            table.Reserve(cell, stepTick(step), until, mobId);
+            if (step == lastStep) break;
+            cell = it->y * ARENA_WIDTH + it->x;
+            ++it;
+        }
+
+        //  Beyond the window, walk down the distance field. Other mobs are ignored there, as the
+        //  mob replans before it gets that far if they are still in the way.
+        if (!reachedEnd) {
+            Point current = path.empty() ? start : path.back();
+            int distance = field.GetDistance(current);
+            while (distance > 0) {
+                for (int i = 0; i < 8; i++) {
+                    Point next = {current.x + NEIGHBOUR_DX[i], current.y + NEIGHBOUR_DY[i]};
+                    if (field.GetDistance(next) != distance - 1) continue;
+                    path.push_back(next);
+                    current = next;
+                    break;
+                }
+                distance--;
+            }
+        }
+        return path;
+    }
+
+    //  END: CooperativePlanner
+
+}
@@ -0,0 +1,118 @@
+#include <core/timer_wheel.hpp>
+#include <core/entity.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace core {
+
+    //  BEGIN: TimerWheel
+
+    TimerWheel::TimerWheel(long long now) : current(now) { }
+
+    void TimerWheel::Schedule(Entity* entity, long long tick) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tick <= current && entity->WakeupTick == DUE) return; // already due
+        unschedule(entity);
+        if (tick <= current) {
+            entity->WakeupTick = DUE;
+            due.push_back(entity);
+        } else {
+            entity->WakeupTick = tick;
+            slotOf(tick).push_back(entity);
+        }
+        scheduledCount++;
+    }
+
+    void TimerWheel::WakeUp(Entity* entity) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entity->WakeupTick == DUE) return; // already due
+        unschedule(entity);
+        entity->WakeupTick = DUE;
+        due.push_back(entity);
+        scheduledCount++;
+    }
+
+    void TimerWheel::Cancel(Entity* entity) {
+        std::lock_guard<std::mutex> lock(mutex);
+        unschedule(entity);
+    }
+
+    void TimerWheel::Advance(long long now) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const long long slotMask = SLOT_COUNT - 1;
+        std::vector<Entity*> moved;
+        while (current < now) {
+            current++;
+
+            // Find the highest level whose slot the clock has just reached, i.e. the level below
+            // which all the digits of the clock have wrapped around to 0.
+            int topLevel = 0;
+            while (topLevel < LEVEL_COUNT
+                && (current & ((1LL << (SLOT_BITS * (topLevel + 1))) - 1)) == 0) topLevel++;
+
+            // Move the reached slots down, from the top
+            if (topLevel == LEVEL_COUNT) {
+                moved.clear();
+                moved.swap(overflow);
+                for (auto entity : moved) slotOf(entity->WakeupTick).push_back(entity);
+            }
+            for (int level = std::min(topLevel, LEVEL_COUNT - 1); level >= 1; level--) {
+                moved.clear();
+                moved.swap(slots[level][(current >> (SLOT_BITS * level)) & slotMask]);
+                for (auto entity : moved) slotOf(entity->WakeupTick).push_back(entity);
+            }
+
+            auto& slot = slots[0][current & slotMask];
+            for (auto entity : slot) {
+                entity->WakeupTick = DUE;
+                due.push_back(entity);
+            }
+            slot.clear();
+        }
+    }
+
+    void TimerWheel::TakeDue(EntityType type, std::vector<Entity*>& taken) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto kept = due.begin();
+        for (auto entity : due) {
+            if (Entity::IsType(entity, type)) {
+                entity->WakeupTick = IDLE;
+                scheduledCount--;
+                taken.push_back(entity);
+            } else {
+                *kept++ = entity;
+            }
+        }
+        due.erase(kept, due.end());
+    }
+
+    int TimerWheel::GetScheduledCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return scheduledCount;
+    }
+
+    std::vector<Entity*>& TimerWheel::slotOf(long long tick) {
+        long long differentBits = tick ^ current;
+        for (int level = 0; level < LEVEL_COUNT; level++) {
+            if ((differentBits >> (SLOT_BITS * (level + 1))) != 0) continue;
+            return slots[level][(tick >> (SLOT_BITS * level)) & (SLOT_COUNT - 1)];
+        }
+        return overflow;
+    }
+
+    void TimerWheel::unschedule(Entity* entity) {
+        if (entity->WakeupTick == IDLE) return;
+        // An entity stays in the slot matching its tick until the clock reaches that slot,
+        // so it can be found again from its tick alone.
+        auto& list = entity->WakeupTick == DUE ? due : slotOf(entity->WakeupTick);
+        auto position = std::find(list.begin(), list.end(), entity);
+        assert(position != list.end());
+        list.erase(position);
+        entity->WakeupTick = IDLE;
+        scheduledCount--;
+    }
+
+    //  END: TimerWheel
+
+}
@@ -3,6 +3,9 @@
 #include <ui/common.hpp>
 #include "game_score_ui.hpp"
 
+#include <cstdlib>
+#include <string>
+
 static core::Game* _game = nullptr;
 
 void gameLvl_configureGameOptions(core::GameOptions* options) {
@@ -12,6 +15,24 @@ void gameLvl_configureGameOptions(core::GameOptions* options) {
 
 void gameLvl_mainGameLoop() {
     util::WriteToLog("gameLvl_mainGameLoop() called. Creating core::Game instance...", "gameLvl_mainGameLoop()");
+    //  Record a trace of the game if asked to, e.g. SHOOT_TRACE=runtime/trace.json ./shoot
+    if (const char* traceFile = std::getenv("SHOOT_TRACE")) gameLvl_gameOptions->TraceFile = traceFile;
+    //  Choose how the arena is drawn, e.g. SHOOT_RENDERER=direct ./shoot
+    if (const char* renderer = std::getenv("SHOOT_RENDERER")) {
+        std::string name = renderer;
+        if (name == "direct") gameLvl_gameOptions->Renderer = core::ArenaRenderer::DIRECT;
+        else if (name == "elements") gameLvl_gameOptions->Renderer = core::ArenaRenderer::ELEMENTS;
+        else util::WriteToLog("Unknown SHOOT_RENDERER: " + name + ", expected direct or elements.", "gameLvl_mainGameLoop()", "WARN");
+    }
+    //  Cap the frame rate, e.g. SHOOT_MAX_FPS=10 ./shoot over a slow link, or 0 for a frame per tick
+    if (const char* maxFps = std::getenv("SHOOT_MAX_FPS")) {
+        std::string value = maxFps;
+        if (!value.empty() && value.size() <= 4 && value.find_first_not_of("0123456789") == std::string::npos) {
+            gameLvl_gameOptions->MaxFramesPerSecond = std::stoi(value);
+        } else {
+            util::WriteToLog("Invalid SHOOT_MAX_FPS: " + value + ", expected a number of frames per second.", "gameLvl_mainGameLoop()", "WARN");
+        }
+    }
     _game = new core::Game(gameLvl_gameOptions);
     ui::publicGameUIRenderer = new ui::GameUIRenderer(_game);
 
@@ -0,0 +1,223 @@
+// The headless simulation runner.
+// Runs a game without the terminal UI and without sleeping between ticks, then prints the
+// simulation speed and the final state of the game as JSON on stdout. Used for load testing
+// on machines without a TTY.
+//
+// Usage: shoot_headless [--map FILE] [--difficulty easy|medium|hard] [--seed N] [--ticks N]
+//                       [--pathfinding flow_field|a_star|jump_point|hierarchical|d_star_lite|cooperative]
+//                       [--max-mobs N] [--spawn-interval N] [--hp N] [--budget MICROS] [--workers N]
+//                       [--log-level debug|info|warn|error|off] [--trace FILE]
+
+// Standard Libraries
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Core Components
+#include <core/arena.hpp>
+#include <core/arena_reader.hpp>
+#include <core/entity.hpp>
+#include <core/game.hpp>
+#include <core/game_options.hpp>
+
+// Misc headers
+#include <util/log.hpp>
+
+// Declarations
+
+//  The pathfinding algorithms by their command line names.
+const std::map<std::string, core::PathfindingAlgorithm> PATHFINDING_NAMES = {
+    {"flow_field", core::PathfindingAlgorithm::FLOW_FIELD},
+    {"a_star", core::PathfindingAlgorithm::A_STAR},
+    {"jump_point", core::PathfindingAlgorithm::JUMP_POINT_SEARCH},
+    {"hierarchical", core::PathfindingAlgorithm::HIERARCHICAL},
+    {"d_star_lite", core::PathfindingAlgorithm::D_STAR_LITE},
+    {"cooperative", core::PathfindingAlgorithm::COOPERATIVE},
+};
+
+//  The log levels by their command line names.
+const std::map<std::string, util::LogLevel> LOG_LEVEL_NAMES = {
+    {"debug", util::LogLevel::DEBUG},
+    {"info", util::LogLevel::INFO},
+    {"warn", util::LogLevel::WARN},
+    {"error", util::LogLevel::ERROR},
+    {"off", util::LogLevel::OFF},
+};
+
+//  Prints the usage to stderr and exits with code 2.
+void printUsageAndExit(const std::string& error);
+//  Parses a non-negative integer argument of at most max, or exits with the usage if it is not one.
+unsigned long long parseNumber(const std::string& flag, const std::string& value, unsigned long long max);
+//  Returns the command line name of the pathfinding algorithm.
+std::string pathfindingName(core::PathfindingAlgorithm algorithm);
+//  Escapes the quotes and backslashes of a string to put it in JSON.
+std::string escapeJson(const std::string& text);
+//  Describes the final state of the game as a JSON object.
+std::string describeGame(core::Game* game, const std::string& map, long long ticks, double elapsedSeconds);
+
+int main(int argc, char** argv) {
+    // Creates runtime directories if they do not exist
+    std::filesystem::create_directories("./runtime");
+    util::WriteToLog("Headless process started.", "main()");
+
+    // Read the command line
+    std::map<std::string, std::string> arguments;
+    for (int i = 1; i < argc; i++) {
+        std::string flag = argv[i];
+        if (flag == "--help" || flag == "-h") printUsageAndExit("");
+        if (flag.rfind("--", 0) != 0 || i + 1 >= argc) printUsageAndExit("Invalid argument: " + flag);
+        arguments[flag] = argv[++i];
+    }
+    for (const auto& argument : arguments) {
+        static const std::set<std::string> flags = {
+            "--map", "--difficulty", "--seed", "--ticks", "--pathfinding",
+            "--max-mobs", "--spawn-interval", "--hp", "--budget", "--workers", "--log-level",
+            "--trace",
+        };
+        if (!flags.count(argument.first)) printUsageAndExit("Unknown option: " + argument.first);
+    }
+
+    if (arguments.count("--log-level")) {
+        auto level = LOG_LEVEL_NAMES.find(arguments["--log-level"]);
+        if (level == LOG_LEVEL_NAMES.end()) printUsageAndExit("Unknown log level: " + arguments["--log-level"]);
+        util::SetLogLevel(level->second);
+    }
+
+    // Build the game options from the difficulty preset, then apply the overrides
+    std::string difficulty = arguments.count("--difficulty") ? arguments["--difficulty"] : "hard";
+    core::GameOptions options;
+    if (difficulty == "easy") options = core::DefaultGameOptions::EASY();
+    else if (difficulty == "medium") options = core::DefaultGameOptions::MEDIUM();
+    else if (difficulty == "hard") options = core::DefaultGameOptions::HARD();
+    else printUsageAndExit("Unknown difficulty: " + difficulty);
+
+    std::string map = "res/default_maps/" + difficulty + ".shoot";
+    if (arguments.count("--map")) {
+        map = arguments["--map"];
+        auto fs = std::ifstream(map);
+        if (!fs.is_open()) printUsageAndExit("Cannot open map: " + map);
+        auto reader = core::ArenaReader(fs);
+        if (!reader.IsSuccess()) printUsageAndExit("Invalid map: " + reader.GetErrorMessage());
+        options.GameArena = reader.GetArena();
+    } else if (options.GameArena == nullptr) {
+        map = "default"; // the built-in map could not be loaded, the game falls back to an empty arena
+    }
+
+    // The numbers are checked against the range of the fields they are stored in
+    const unsigned long long INT_RANGE = std::numeric_limits<int>::max();
+    options.Seed = arguments.count("--seed")
+        ? parseNumber("--seed", arguments["--seed"], std::numeric_limits<unsigned long long>::max()) : 1;
+    long long ticks = arguments.count("--ticks")
+        ? parseNumber("--ticks", arguments["--ticks"], std::numeric_limits<long long>::max()) : 3000;
+    if (arguments.count("--pathfinding")) {
+        auto algorithm = PATHFINDING_NAMES.find(arguments["--pathfinding"]);
+        if (algorithm == PATHFINDING_NAMES.end()) printUsageAndExit("Unknown pathfinding algorithm: " + arguments["--pathfinding"]);
+        options.MobPathfinding = algorithm->second;
+    }
+    if (arguments.count("--max-mobs")) options.MaxMobs = parseNumber("--max-mobs", arguments["--max-mobs"], INT_RANGE);
+    if (arguments.count("--spawn-interval")) options.MobSpawnInterval = parseNumber("--spawn-interval", arguments["--spawn-interval"], INT_RANGE);
+    if (arguments.count("--hp")) options.PlayerHp = parseNumber("--hp", arguments["--hp"], INT_RANGE);
+    if (arguments.count("--budget")) options.PathfindingBudgetMicros = parseNumber("--budget", arguments["--budget"], INT_RANGE);
+    if (arguments.count("--workers")) options.PathfindingWorkers = parseNumber("--workers", arguments["--workers"], INT_RANGE);
+    if (arguments.count("--trace")) options.TraceFile = arguments["--trace"];
+
+    // Run the simulation
+    auto game = new core::Game(&options);
+    auto start = std::chrono::steady_clock::now();
+    game->RunHeadless(ticks);
+    double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << describeGame(game, map, ticks, elapsedSeconds) << std::endl;
+    delete game;
+    util::WriteToLog("Headless process exited.", "main()");
+    return 0;
+}
+
+void printUsageAndExit(const std::string& error) {
+    if (!error.empty()) std::cerr << "shoot_headless: " << error << std::endl;
+    std::cerr << "Usage: shoot_headless [--map FILE] [--difficulty easy|medium|hard] [--seed N] [--ticks N]" << std::endl
+              << "                      [--pathfinding flow_field|a_star|jump_point|hierarchical|d_star_lite|cooperative]" << std::endl
+              << "                      [--max-mobs N] [--spawn-interval N] [--hp N] [--budget MICROS] [--workers N]" << std::endl
+              << "                      [--log-level debug|info|warn|error|off] [--trace FILE]" << std::endl;
+    std::exit(error.empty() ? 0 : 2);
+}
+
+unsigned long long parseNumber(const std::string& flag, const std::string& value, unsigned long long max) {
+    if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos) {
+        printUsageAndExit("Expected a non-negative integer for " + flag + ", got: " + value);
+    }
+    try {
+        unsigned long long number = std::stoull(value);
+        if (number <= max) return number;
+    } catch (const std::out_of_range&) {
+        // too large even for unsigned long long, reported below
+    }
+    printUsageAndExit("Number too large for " + flag + " (at most " + std::to_string(max) + "): " + value);
+    return 0;
+}
+
+std::string pathfindingName(core::PathfindingAlgorithm algorithm) {
+    for (const auto& entry : PATHFINDING_NAMES) {
+        if (entry.second == algorithm) return entry.first;
+    }
+    return "unknown";
+}
+
+std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+std::string describeGame(core::Game* game, const std::string& map, long long ticks, double elapsedSeconds) {
+    auto arena = game->GetArena();
+    auto player = static_cast<core::Player*>(arena->GetPixelById(0));
+    long long ticksRun = game->GetGameClock();
+
+    // Count the entities left on the arena
+    std::map<std::string, int> mobs = {{"zombie", 0}, {"troll", 0}, {"baby_zombie", 0}, {"monster", 0}, {"boss", 0}};
+    for (auto entity : arena->GetMappedEntities()) {
+        if (core::Entity::IsType(entity, core::EntityType::ZOMBIE)) mobs["zombie"]++;
+        else if (core::Entity::IsType(entity, core::EntityType::TROLL)) mobs["troll"]++;
+        else if (core::Entity::IsType(entity, core::EntityType::BABY_ZOMBIE)) mobs["baby_zombie"]++;
+        else if (core::Entity::IsType(entity, core::EntityType::MONSTER)) mobs["monster"]++;
+        else if (core::Entity::IsType(entity, core::EntityType::BOSS)) mobs["boss"]++;
+    }
+    int collectibles = static_cast<int>(arena->GetEntitiesOfType(core::EntityType::ABSTRACT_COLLECTIBLE).size());
+
+    std::ostringstream json;
+    json << "{";
+    json << "\"map\": \"" << escapeJson(map) << "\", ";
+    json << "\"difficulty\": " << game->GetOptions()->DifficultyLevel << ", ";
+    json << "\"seed\": " << game->GetSeed() << ", ";
+    json << "\"pathfinding\": \"" << pathfindingName(game->GetOptions()->MobPathfinding) << "\", ";
+    json << "\"ticks_requested\": " << ticks << ", ";
+    json << "\"ticks_run\": " << ticksRun << ", ";
+    json << "\"elapsed_seconds\": " << elapsedSeconds << ", ";
+    json << "\"ticks_per_second\": " << (elapsedSeconds > 0 ? ticksRun / elapsedSeconds : 0.0) << ", ";
+    json << "\"terminate_reason\": \"" << (game->GetTerminateReason() == 0 ? "game_over" : "tick_limit") << "\", ";
+    json << "\"score\": " << game->GetScore() << ", ";
+    json << "\"player\": {\"hp\": " << player->GetHP() << ", \"damage\": " << player->GetDamage()
+         << ", \"x\": " << player->GetPosition().x << ", \"y\": " << player->GetPosition().y << "}, ";
+    json << "\"mobs\": {";
+    int totalMobs = 0;
+    for (const auto& entry : mobs) {
+        json << "\"" << entry.first << "\": " << entry.second << ", ";
+        totalMobs += entry.second;
+    }
+    json << "\"total\": " << totalMobs << "}, ";
+    json << "\"collectibles\": " << collectibles;
+    json << "}";
+    return json.str();
+}
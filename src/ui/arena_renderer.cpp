@@ -0,0 +1,56 @@
+#include <ui/arena_renderer.hpp>
+
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/screen.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+
+namespace ui {
+
+    //  Draws the arena of a frame straight into the screen buffer.
+    class DirectArenaNode : public ftxui::Node {
+        public:
+            DirectArenaNode(const core::FrameSnapshot& frame, long long* drawMicros) : frame(frame), drawMicros(drawMicros) { }
+
+            void ComputeRequirement() override {
+                requirement_.min_x = ARENA_WIDTH;
+                requirement_.min_y = ARENA_HEIGHT;
+            }
+
+            void Render(ftxui::Screen& screen) override {
+                auto start = std::chrono::steady_clock::now();
+                for (int y = 0; y < ARENA_HEIGHT && box_.y_min + y <= box_.y_max; y++) {
+                    for (int x = 0; x < ARENA_WIDTH && box_.x_min + x <= box_.x_max; x++) {
+                        const RenderOption& option = frame.Cells[y][x];
+                        const Style& style = StyleTable::Get(option.GetStyle());
+                        auto& pixel = screen.PixelAt(box_.x_min + x, box_.y_min + y);
+                        pixel.character = std::string(1, option.GetChar());
+                        pixel.foreground_color = style.Foreground;
+                        pixel.background_color = IsOnLineOfFire(frame, x, y) ? ftxui::Color(ftxui::Color::Grey30) : style.Background;
+                        pixel.bold = style.Bold;
+                        pixel.italic = style.Italic;
+                        pixel.underlined = style.Underline;
+                        pixel.blink = style.Blink;
+                    }
+                }
+                if (drawMicros) *drawMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            }
+
+        private:
+            const core::FrameSnapshot& frame;
+            long long* drawMicros;
+    };
+
+    bool IsOnLineOfFire(const core::FrameSnapshot& frame, int x, int y) {
+        core::Point playerPos = frame.PlayerPosition;
+        return !frame.Collectible[y][x]
+            && (x == playerPos.x || y == playerPos.y || std::abs(x - playerPos.x) == std::abs(y - playerPos.y));
+    }
+
+    ftxui::Element DirectArena(const core::FrameSnapshot& frame, long long* drawMicros) {
+        return std::make_shared<DirectArenaNode>(frame, drawMicros);
+    }
+
+}
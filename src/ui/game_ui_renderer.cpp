@@ -1,69 +1,82 @@
+#include <ui/arena_renderer.hpp>
 #include <ui/common.hpp>
 #include <ui/game_ui_renderer.hpp>
 
 #include <util/log.hpp>
+#include <util/trace.hpp>
 
 #include <ftxui/component/component.hpp>
+#include <ftxui/dom/node.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <vector>
 #include <string>
 
 namespace ui {
 
-    GameUIRenderer::GameUIRenderer(core::Game* game) : game(game) { }
+    GameUIRenderer::GameUIRenderer(core::Game* game) : game(game) {
+        showHandlerProfile = game->GetOptions()->ShowHandlerProfile;
+        rowElements.resize(ARENA_HEIGHT);
+        rowVersions.resize(ARENA_HEIGHT, -1);
+    }
 
     void GameUIRenderer::StartRenderLoop() {
         util::WriteToLog("Starting game UI renderer...", "GameUIRenderer::StartRenderLoop()");
         auto ui = ftxui::Renderer([&] {
-            //  Render the game arena
-            std::vector<ftxui::Element> allRows;
-            allRows.reserve(ARENA_HEIGHT);
-            core::Point playerPos = game->GetArena()->GetPixelById(0)->GetPosition();
-            for (int y = 0; y < ARENA_HEIGHT; y++) {
-                std::vector<ftxui::Element> rowElements;
-                rowElements.reserve(ARENA_WIDTH);
-                for (int x = 0; x < ARENA_WIDTH; x++) {
-                    auto entity = game->GetArena()->GetPixel({x, y});
-                    auto element = entity->GetRenderOption().Render();
-                    if (!core::Entity::IsType(entity, core::EntityType::ABSTRACT_COLLECTIBLE) // if the entity is not a collectible
-                        && (
-                            x == playerPos.x || y == playerPos.y  // and is in the same row or column as the player
-                            || std::abs(x - playerPos.x) == std::abs(y - playerPos.y)  // or is in the diagonal of the player
-                        )) {       
-                        element = element | ftxui::bgcolor(ftxui::Color::Grey30); // then render it grey
-                    }
-                    rowElements.push_back(element);
-                }
-                allRows.push_back(ftxui::hbox(rowElements));
-            }
-            auto rows = ftxui::vbox(allRows)    | ftxui::size(ftxui::WIDTH, ftxui::GREATER_THAN, ARENA_WIDTH) 
-                                                | ftxui::size(ftxui::HEIGHT, ftxui::EQUAL, ARENA_HEIGHT)
-                                                | ftxui::hcenter;
+            util::TraceSpan span("GameUIRenderer::render");
+            //  Draw from the latest frame published by the tick thread. It is not changed while
+            //  it is drawn, so no lock is needed.
+            const core::FrameSnapshot& frame = game->GetLatestFrame();
+
+            //  A frame that has not changed since the last one built has the same arena, e.g. when
+            //  the screen is redrawn for a key press. The rest of the screen shows live counters,
+            //  so it is built every time.
+            bool reused = lastArena && frame.Version == lastFrameVersion;
+            game->MarkFrameDrawn(reused);
+            if (!reused) {
+                lastFrameVersion = frame.Version;
+                lastArena = renderArena(frame);
+            }
 
             //  Render other components
-            float hp = (float) dynamic_cast<core::Player*>(game->GetArena()->GetPixelById(0))->GetHP() / (float) game->GetOptions()->PlayerHp;
+            float hp = (float) frame.PlayerHp / (float) game->GetOptions()->PlayerHp;
             auto hpColour = hp > 0.5 ? ftxui::Color::Green : (hp > 0.25 ? ftxui::Color::Yellow : ftxui::Color::Red);
+            auto tickStats = game->GetTickTimingStats();
+            auto tickColour = tickStats.LastTickMicros > core::Game::TICK_MICROS ? ftxui::Color::Red : ftxui::Color::GrayLight;
+            auto inputStats = game->GetInputLatencyStats();
 
             return ftxui::vbox({
-                rows,
+                lastArena,
                 ftxui::separator(),
                 ftxui::hbox({
                     ftxui::text(" HP: ") | ftxui::bold,
                     ftxui::gauge(hp)    | ftxui::size(ftxui::WIDTH, ftxui::EQUAL, 15)
                                             | ftxui::color(hpColour),
-                    ftxui::text(" " + std::to_string(dynamic_cast<core::Player*>(game->GetArena()->GetPixelById(0))->GetHP()) + " / " + std::to_string(game->GetOptions()->PlayerHp) + " ")
+                    ftxui::text(" " + std::to_string(frame.PlayerHp) + " / " + std::to_string(game->GetOptions()->PlayerHp) + " ")
                         | ftxui::color(hpColour),
                     ftxui::separator(),
                     ftxui::text(" Score: ") | ftxui::bold,
-                    ftxui::text(std::to_string(game->GetScore()) + " ") | ftxui::color(ftxui::Color::Cyan),
+                    ftxui::text(std::to_string(frame.Score) + " ") | ftxui::color(ftxui::Color::Cyan),
                     ftxui::separator(),
                     ftxui::text(" Damage: ") | ftxui::bold,
-                    ftxui::text(std::to_string(dynamic_cast<core::Player*>(game->GetArena()->GetPixelById(0))->GetDamage()) + " ") | ftxui::color(ftxui::Color::Red),
+                    ftxui::text(std::to_string(frame.PlayerDamage) + " ") | ftxui::color(ftxui::Color::Red),
+                    ftxui::separator(),
+                    ftxui::text(" Tick: ") | ftxui::bold,
+                    ftxui::text(std::to_string(tickStats.LastTickMicros / 1000) + "." + std::to_string(tickStats.LastTickMicros / 100 % 10) + " ms ("
+                        + std::to_string(tickStats.Overruns) + " over, " + std::to_string(tickStats.DroppedTicks) + " drop) ")
+                        | ftxui::color(tickColour),
+                    ftxui::separator(),
+                    ftxui::text(" Input: ") | ftxui::bold,
+                    ftxui::text(std::to_string(inputStats.LastMicros / 1000) + "." + std::to_string(inputStats.LastMicros / 100 % 10) + " ms ")
+                        | ftxui::color(ftxui::Color::GrayLight),
                 }),
                 ftxui::separator(),
-                ftxui::text(" INSTRUCTIONS:") | ftxui::bold,
-                ftxui::paragraphAlignLeft("  - Move: W/A/S/D (or Q/Z/C/E for diagonal movements)"),
-                ftxui::paragraphAlignLeft("  - Shoot a bullet: I/J/K/L (or U/O/M/. for diagonal; space for all directions (5 seconds cooldown))")
+                showHandlerProfile ? renderHandlerProfile() : ftxui::vbox({
+                    ftxui::text(" INSTRUCTIONS: (P: handler times)") | ftxui::bold,
+                    ftxui::paragraphAlignLeft("  - Move: W/A/S/D (or Q/Z/C/E for diagonal movements)"),
+                    ftxui::paragraphAlignLeft("  - Shoot a bullet: I/J/K/L (or U/O/M/. for diagonal; space for all directions (5 seconds cooldown))")
+                })
             })  | ftxui::size(ftxui::WIDTH, ftxui::EQUAL, MIN_TERMINAL_WIDTH)
                 | ftxui::size(ftxui::HEIGHT, ftxui::LESS_THAN, MIN_TERMINAL_HEIGHT + 1)
                 | ftxui::borderRounded;
@@ -80,49 +93,47 @@ namespace ui {
             if (event == ftxui::Event::Custom) {
                 return true;
             }
+            if (event == ftxui::Event::Character('p')) { // Toggle the handler times
+                showHandlerProfile = !showHandlerProfile;
+                return true;
+            }
 
             // ==============================================================================================
             //     Player movement events
+            //     Key presses are queued for the tick thread, which applies them at the start of the
+            //     next tick, so the UI thread never touches the arena.
             // ==============================================================================================
 
             if (event == ftxui::Event::Character('w')) {
-                game->PlayerMoveEventHandlerPtr->SetDirection(core::PlayerMoveEventHandler::Direction::UP);
-                game->PlayerMoveEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::MOVE, static_cast<int>(core::PlayerMoveEventHandler::Direction::UP));
                 return true;
             }
             if (event == ftxui::Event::Character('q')) {
-                game->PlayerMoveEventHandlerPtr->SetDirection(core::PlayerMoveEventHandler::Direction::UP_LEFT);
-                game->PlayerMoveEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::MOVE, static_cast<int>(core::PlayerMoveEventHandler::Direction::UP_LEFT));
                 return true;
             }
             if (event == ftxui::Event::Character('a')) {
-                game->PlayerMoveEventHandlerPtr->SetDirection(core::PlayerMoveEventHandler::Direction::LEFT);
-                game->PlayerMoveEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::MOVE, static_cast<int>(core::PlayerMoveEventHandler::Direction::LEFT));
                 return true;
             }
             if (event == ftxui::Event::Character('z')) {
-                game->PlayerMoveEventHandlerPtr->SetDirection(core::PlayerMoveEventHandler::Direction::DOWN_LEFT);
-                game->PlayerMoveEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::MOVE, static_cast<int>(core::PlayerMoveEventHandler::Direction::DOWN_LEFT));
                 return true;
             }
             if (event == ftxui::Event::Character('s')) {
-                game->PlayerMoveEventHandlerPtr->SetDirection(core::PlayerMoveEventHandler::Direction::DOWN);
-                game->PlayerMoveEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::MOVE, static_cast<int>(core::PlayerMoveEventHandler::Direction::DOWN));
                 return true;
             }
             if (event == ftxui::Event::Character('c')) {
-                game->PlayerMoveEventHandlerPtr->SetDirection(core::PlayerMoveEventHandler::Direction::DOWN_RIGHT);
-                game->PlayerMoveEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::MOVE, static_cast<int>(core::PlayerMoveEventHandler::Direction::DOWN_RIGHT));
                 return true;
             }
             if (event == ftxui::Event::Character('d')) {
-                game->PlayerMoveEventHandlerPtr->SetDirection(core::PlayerMoveEventHandler::Direction::RIGHT);
-                game->PlayerMoveEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::MOVE, static_cast<int>(core::PlayerMoveEventHandler::Direction::RIGHT));
                 return true;
             }
             if (event == ftxui::Event::Character('e')) {
-                game->PlayerMoveEventHandlerPtr->SetDirection(core::PlayerMoveEventHandler::Direction::UP_RIGHT);
-                game->PlayerMoveEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::MOVE, static_cast<int>(core::PlayerMoveEventHandler::Direction::UP_RIGHT));
                 return true;
             }
             
@@ -131,52 +142,132 @@ namespace ui {
             // ==============================================================================================
             
             if (event == ftxui::Event::Character('i')) {
-                game->PlayerShootEventHandlerPtr->SetBulletDirection(0);
-                game->PlayerShootEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::SHOOT, 0);
                 return true;
             }
             if (event == ftxui::Event::Character('u')) {
-                game->PlayerShootEventHandlerPtr->SetBulletDirection(1);
-                game->PlayerShootEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::SHOOT, 1);
                 return true;
             }
             if (event == ftxui::Event::Character('j')) {
-                game->PlayerShootEventHandlerPtr->SetBulletDirection(2);
-                game->PlayerShootEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::SHOOT, 2);
                 return true;
             }
             if (event == ftxui::Event::Character('m')) {
-                game->PlayerShootEventHandlerPtr->SetBulletDirection(3);
-                game->PlayerShootEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::SHOOT, 3);
                 return true;
             }
             if (event == ftxui::Event::Character('k')) {
-                game->PlayerShootEventHandlerPtr->SetBulletDirection(4);
-                game->PlayerShootEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::SHOOT, 4);
                 return true;
             }
             if (event == ftxui::Event::Character('.')) {
-                game->PlayerShootEventHandlerPtr->SetBulletDirection(5);
-                game->PlayerShootEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::SHOOT, 5);
                 return true;
             }
             if (event == ftxui::Event::Character('l')) {
-                game->PlayerShootEventHandlerPtr->SetBulletDirection(6);
-                game->PlayerShootEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::SHOOT, 6);
                 return true;
             }
             if (event == ftxui::Event::Character('o')) {
-                game->PlayerShootEventHandlerPtr->SetBulletDirection(7);
-                game->PlayerShootEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::SHOOT, 7);
                 return true;
             }
             if (event == ftxui::Event::Character(' ')) {
-                game->PlayerShootEventHandlerPtr->SetBulletDirection(8);
-                game->PlayerShootEventHandlerPtr->Fire();
+                game->PushInput(core::InputCommand::Type::SHOOT, 8);
                 return true;
             }
             return false;
         })  | ftxui::center;
         ui::appScreen.Loop(ui);
+        if (game->GetOptions()->Renderer == core::ArenaRenderer::DIRECT) {
+            util::WriteToLog("Built the arena of " + std::to_string(frameCount) + " frames with the direct renderer in "
+                + std::to_string(frameCount > 0 ? totalBuildMicros / frameCount : 0) + " us on average; ftxui printed "
+                + std::to_string(sampledFrames > 0 ? totalArenaBytes / sampledFrames : 0) + " bytes per frame for the arena alone, over "
+                + std::to_string(sampledFrames) + " sampled frames.", "GameUIRenderer::StartRenderLoop()");
+        } else {
+            util::WriteToLog("Built the arena of " + std::to_string(frameCount) + " frames in "
+                + std::to_string(frameCount > 0 ? totalBuildMicros / frameCount : 0) + " us on average, rebuilding "
+                + std::to_string(rebuiltRows) + " rows.", "GameUIRenderer::StartRenderLoop()");
+        }
+        auto redraws = game->GetRedrawStats();
+        util::WriteToLog("Redraws: " + std::to_string(redraws.Requested) + " requested, " + std::to_string(redraws.Coalesced)
+            + " coalesced, " + std::to_string(redraws.Unchanged) + " ticks unchanged; " + std::to_string(redraws.Drawn)
+            + " frames drawn, " + std::to_string(redraws.Reused) + " reused (max "
+            + std::to_string(game->GetOptions()->MaxFramesPerSecond) + " fps).", "GameUIRenderer::StartRenderLoop()");
+    }
+
+    ftxui::Element GameUIRenderer::renderArena(const core::FrameSnapshot& frame) {
+        //  Render the game arena
+        auto buildStart = std::chrono::steady_clock::now();
+        ftxui::Element arena;
+        if (game->GetOptions()->Renderer == core::ArenaRenderer::DIRECT) {
+            arena = DirectArena(frame, &totalBuildMicros); // the cells are only drawn later, the time is added then
+        } else {
+            //  Rebuild only the rows that changed
+            if (frame.PlayerPosition.x != highlightOrigin.x || frame.PlayerPosition.y != highlightOrigin.y) {
+                highlightOrigin = frame.PlayerPosition;
+                std::fill(rowVersions.begin(), rowVersions.end(), -1);
+            }
+            for (int y = 0; y < ARENA_HEIGHT; y++) {
+                if (rowVersions[y] == frame.RowVersion[y]) continue;
+                rowElements[y] = renderRow(frame, y);
+                rowVersions[y] = frame.RowVersion[y];
+                rebuiltRows++;
+            }
+            arena = ftxui::vbox(rowElements);
+        }
+        auto rows = arena   | ftxui::size(ftxui::WIDTH, ftxui::GREATER_THAN, ARENA_WIDTH) 
+                            | ftxui::size(ftxui::HEIGHT, ftxui::EQUAL, ARENA_HEIGHT)
+                            | ftxui::hcenter;
+        frameCount++;
+        totalBuildMicros += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - buildStart).count();
+
+        //  Count the bytes ftxui prints for the arena on a sample of the frames. The rest of the
+        //  screen is not counted.
+        if (game->GetOptions()->Renderer == core::ArenaRenderer::DIRECT && frameCount % ARENA_BYTES_SAMPLE_INTERVAL == 1) {
+            ftxui::Render(arenaScreen, DirectArena(frame));
+            totalArenaBytes += arenaScreen.ToString().size();
+            sampledFrames++;
+        }
+        return rows;
+    }
+
+    ftxui::Element GameUIRenderer::renderHandlerProfile() {
+        auto millis = [](long long micros) {
+            return std::to_string(micros / 1000) + "." + std::to_string(micros / 100 % 10);
+        };
+        std::vector<ftxui::Element> lines[2];
+        int count = static_cast<int>(core::ProfiledHandler::COUNT);
+        for (int i = 0; i < count; i++) {
+            auto handler = static_cast<core::ProfiledHandler>(i);
+            const auto& profile = game->GetHandlerProfile(handler);
+            long long p99 = profile.GetPercentile(99);
+            //  Highlight the handlers that take a large share of the tick budget
+            auto colour = p99 > core::Game::TICK_MICROS / 2 ? ftxui::Color::Red
+                : (p99 > core::Game::TICK_MICROS / 10 ? ftxui::Color::Yellow : ftxui::Color::GrayLight);
+            auto& line = lines[i < (count + 1) / 2 ? 0 : 1];
+            line.push_back(ftxui::text(std::string(" ") + core::GetProfiledHandlerName(handler) + ": ") | ftxui::bold);
+            line.push_back(ftxui::text(millis(profile.GetPercentile(50)) + "/" + millis(p99) + "/" + millis(profile.GetMax()) + " ")
+                | ftxui::color(colour));
+        }
+        return ftxui::vbox({
+            ftxui::text(" HANDLER TIMES: p50/p99/max in ms, tick budget " + millis(core::Game::TICK_MICROS) + " ms (P: instructions)") | ftxui::bold,
+            ftxui::hbox(lines[0]),
+            ftxui::hbox(lines[1]),
+        });
+    }
+
+    ftxui::Element GameUIRenderer::renderRow(const core::FrameSnapshot& frame, int y) {
+        std::vector<ftxui::Element> rowElements;
+        rowElements.reserve(ARENA_WIDTH);
+        for (int x = 0; x < ARENA_WIDTH; x++) {
+            auto element = frame.Cells[y][x].Render();
+            if (IsOnLineOfFire(frame, x, y)) {
+                element = element | ftxui::bgcolor(ftxui::Color::Grey30); // render the lines of fire grey
+            }
+            rowElements.push_back(element);
+        }
+        return ftxui::hbox(rowElements);
     }
 }
\ No newline at end of file
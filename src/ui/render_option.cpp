@@ -2,30 +2,43 @@
 #include <util/log.hpp>
 
 namespace ui {
-    ftxui::Color RenderOption::GetForeground() { return foregroundColour; }
-    void RenderOption::SetForeground(ftxui::Color fcolour) { foregroundColour = fcolour; }
-    ftxui::Color RenderOption::GetBackground() { return backgroundColour; }
-    void RenderOption::SetBackground(ftxui::Color bcolour) { backgroundColour = bcolour; }
-    bool RenderOption::GetBold() { return bold; }
-    void RenderOption::SetBold(bool b) { bold = b; }
-    bool RenderOption::GetItalic() { return italic; }
-    void RenderOption::SetItalic(bool b) { italic = b; }
-    bool RenderOption::GetUnderline() { return underline; }
-    void RenderOption::SetUnderline(bool b) { underline = b; }
-    bool RenderOption::GetBlink() { return blink; }
-    void RenderOption::SetBlink(bool b) { blink = b; }
-    char RenderOption::GetChar() { return character; }
+    RenderOption::RenderOption(char c, ftxui::Color fcolour, ftxui::Color bcolour, bool bold, bool italic, bool underline, bool blink)
+        : character(c) {
+        Style newStyle;
+        newStyle.Foreground = fcolour;
+        newStyle.Background = bcolour;
+        newStyle.Bold = bold;
+        newStyle.Italic = italic;
+        newStyle.Underline = underline;
+        newStyle.Blink = blink;
+        setStyle(newStyle);
+    }
+    ftxui::Color RenderOption::GetForeground() const { return StyleTable::Get(style).Foreground; }
+    void RenderOption::SetForeground(ftxui::Color fcolour) { Style s = StyleTable::Get(style); s.Foreground = fcolour; setStyle(s); }
+    ftxui::Color RenderOption::GetBackground() const { return StyleTable::Get(style).Background; }
+    void RenderOption::SetBackground(ftxui::Color bcolour) { Style s = StyleTable::Get(style); s.Background = bcolour; setStyle(s); }
+    bool RenderOption::GetBold() const { return StyleTable::Get(style).Bold; }
+    void RenderOption::SetBold(bool b) { Style s = StyleTable::Get(style); s.Bold = b; setStyle(s); }
+    bool RenderOption::GetItalic() const { return StyleTable::Get(style).Italic; }
+    void RenderOption::SetItalic(bool b) { Style s = StyleTable::Get(style); s.Italic = b; setStyle(s); }
+    bool RenderOption::GetUnderline() const { return StyleTable::Get(style).Underline; }
+    void RenderOption::SetUnderline(bool b) { Style s = StyleTable::Get(style); s.Underline = b; setStyle(s); }
+    bool RenderOption::GetBlink() const { return StyleTable::Get(style).Blink; }
+    void RenderOption::SetBlink(bool b) { Style s = StyleTable::Get(style); s.Blink = b; setStyle(s); }
+    char RenderOption::GetChar() const { return character; }
     void RenderOption::SetChar(char c) { character = c; }
-    ftxui::Element RenderOption::Render() {
-        ftxui::Element ele = ftxui::text(std::string(1, character))
-                                | ftxui::color(foregroundColour)
-                                | ftxui::bgcolor(backgroundColour);
-        if (bold) ele |= ftxui::bold;
-        if (italic) ele |= ftxui::italic;
-        if (underline) ele |= ftxui::underlined;
-        if (blink) ele |= ftxui::blink;
-        ele |= ftxui::size(ftxui::WIDTH, ftxui::EQUAL, 1);
-        ele |= ftxui::size(ftxui::HEIGHT, ftxui::EQUAL, 1);
-        return ele;
+    StyleId RenderOption::GetStyle() const { return style; }
+    void RenderOption::setStyle(const Style& newStyle) {
+        if (newStyle == StyleTable::Get(style)) return; // unchanged, e.g. a shield that was already off
+        style = StyleTable::Intern(newStyle);
+    }
+    ftxui::Element RenderOption::Render() const {
+        // Call the cached decorator in place: `element | decorator` would copy it, and with it
+        // every decorator it is composed of.
+        return StyleTable::GetDecorator(style)(ftxui::text(std::string(1, character)));
+    }
+    bool RenderOption::operator==(const RenderOption& other) const {
+        return character == other.character && style == other.style;
     }
-}
\ No newline at end of file
+    bool RenderOption::operator!=(const RenderOption& other) const { return !(*this == other); }
+}
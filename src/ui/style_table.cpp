@@ -0,0 +1,84 @@
+#include <ui/style_table.hpp>
+#include <util/log.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace ui {
+
+    bool Style::operator==(const Style& other) const {
+        return Foreground == other.Foreground && Background == other.Background
+            && Bold == other.Bold && Italic == other.Italic && Underline == other.Underline && Blink == other.Blink;
+    }
+
+    bool Style::operator!=(const Style& other) const { return !(*this == other); }
+
+    namespace {
+
+        //  An interned style and the decorator drawing it.
+        struct StyleEntry {
+            Style Value;
+            ftxui::Decorator Decorator;
+        };
+
+        //  The storage of the table. Entries are only appended, and never change once the size
+        //  covering them is published, so they can be read without the lock.
+        struct StyleStorage {
+            StyleEntry Entries[StyleTable::CAPACITY];
+            std::atomic<int> Size{0};
+            std::mutex Mutex;
+        };
+
+        ftxui::Decorator buildDecorator(const Style& style) {
+            ftxui::Decorator decorator = ftxui::color(style.Foreground) | ftxui::bgcolor(style.Background);
+            if (style.Bold) decorator = decorator | ftxui::Decorator(ftxui::bold);
+            if (style.Italic) decorator = decorator | ftxui::Decorator(ftxui::italic);
+            if (style.Underline) decorator = decorator | ftxui::Decorator(ftxui::underlined);
+            if (style.Blink) decorator = decorator | ftxui::Decorator(ftxui::blink);
+            return decorator | ftxui::size(ftxui::WIDTH, ftxui::EQUAL, 1) | ftxui::size(ftxui::HEIGHT, ftxui::EQUAL, 1);
+        }
+
+        //  Returns the storage, creating it with the default style on first use. Styles are
+        //  interned while static entities are constructed, so the storage cannot be a plain global.
+        StyleStorage& storage() {
+            static StyleStorage* table = [] {
+                auto table = new StyleStorage();
+                table->Entries[StyleTable::DEFAULT] = {Style(), buildDecorator(Style())};
+                table->Size.store(1, std::memory_order_release);
+                return table;
+            }();
+            return *table;
+        }
+
+    }
+
+    StyleId StyleTable::Intern(const Style& style) {
+        auto& table = storage();
+        std::lock_guard<std::mutex> lock(table.Mutex);
+        int size = table.Size.load(std::memory_order_relaxed);
+        for (int id = 0; id < size; id++) {
+            if (table.Entries[id].Value == style) return static_cast<StyleId>(id);
+        }
+        if (size == CAPACITY) {
+            util::WriteToLog("Style table full, falling back to the default style.", "StyleTable::Intern()", "WARN");
+            return DEFAULT;
+        }
+        table.Entries[size] = {style, buildDecorator(style)};
+        table.Size.store(size + 1, std::memory_order_release);
+        return static_cast<StyleId>(size);
+    }
+
+    const Style& StyleTable::Get(StyleId id) {
+        return storage().Entries[id].Value;
+    }
+
+    const ftxui::Decorator& StyleTable::GetDecorator(StyleId id) {
+        return storage().Entries[id].Decorator;
+    }
+
+    int StyleTable::GetSize() {
+        return storage().Size.load(std::memory_order_acquire);
+    }
+
+}
@@ -0,0 +1,66 @@
+#include <util/latency_histogram.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace util {
+
+    void LatencyHistogram::Record(long long micros) {
+        micros = std::min(std::max(micros, 0LL), (1LL << MAX_BITS) - 1);
+        //  A single thread records, so plain loads and stores are enough
+        auto& bucket = counts[bucketOf(micros)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total.store(total.load(std::memory_order_relaxed) + micros, std::memory_order_relaxed);
+        if (micros > max.load(std::memory_order_relaxed)) max.store(micros, std::memory_order_relaxed);
+        count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    long long LatencyHistogram::GetCount() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    double LatencyHistogram::GetMean() const {
+        long long recorded = GetCount();
+        return recorded > 0 ? static_cast<double>(total.load(std::memory_order_relaxed)) / recorded : 0;
+    }
+
+    long long LatencyHistogram::GetMax() const {
+        return max.load(std::memory_order_relaxed);
+    }
+
+    long long LatencyHistogram::GetPercentile(double percentile) const {
+        long long recorded = GetCount();
+        if (recorded == 0) return 0;
+        long long rank = std::max(1LL, static_cast<long long>(std::ceil(std::min(percentile, 100.0) / 100 * recorded)));
+        long long seen = 0;
+        for (int bucket = 0; bucket < BUCKETS; bucket++) {
+            seen += counts[bucket].load(std::memory_order_relaxed);
+            if (seen >= rank) return std::min(highestIn(bucket), GetMax());
+        }
+        return GetMax(); // only while a recording is half counted
+    }
+
+    void LatencyHistogram::Reset() {
+        for (auto& bucket : counts) bucket.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+    int LatencyHistogram::bucketOf(long long micros) {
+        if (micros < SUB_BUCKETS) return static_cast<int>(micros);
+        //  Drop low bits until the value fits the sub-buckets. That keeps its top SUB_BUCKET_BITS bits,
+        //  the highest of which is set, so it lands in the upper half.
+        int shift = 1;
+        while ((micros >> shift) >= SUB_BUCKETS) shift++;
+        return SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS + static_cast<int>((micros >> shift) - HALF_SUB_BUCKETS);
+    }
+
+    long long LatencyHistogram::highestIn(int bucket) {
+        if (bucket < SUB_BUCKETS) return bucket;
+        int shift = (bucket - SUB_BUCKETS) / HALF_SUB_BUCKETS + 1;
+        long long first = static_cast<long long>((bucket - SUB_BUCKETS) % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS) << shift;
+        return first + (1LL << shift) - 1;
+    }
+
+}
@@ -2,34 +2,239 @@
 
 #include <fstream>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
-#include <iomanip>
-#include <sstream>
+#include <mutex>
+#include <thread>
 
 namespace util {
-    void WriteToLog(const std::string& message, const std::string& caller, const std::string& tag) {
-        const std::string logFile = "./runtime/game.log";
-        std::ofstream logStream(logFile.c_str(), std::ofstream::app);
-        if (!logStream.is_open()) {
-            // Try to create the file if it doesn't exist
-            logStream.open(logFile.c_str(), std::ofstream::out | std::ofstream::trunc);
-            logStream << std::endl;
-            logStream.close();
+
+    namespace {
+
+        const char* const LOG_FILE = "./runtime/game.log";
+        //  The number of records the queue holds. Must be a power of two.
+        constexpr std::size_t LOG_CAPACITY = 1024;
+        //  The longest record, including its timestamp and the line break.
+        constexpr std::size_t LOG_RECORD_SIZE = 512;
+
+        //  A formatted record. Sequence tells whose turn the slot is: a producer may fill it when
+        //  it equals the position claimed, and the writer may take it when it is one more.
+        struct LogSlot {
+            std::atomic<std::size_t> Sequence;
+            std::size_t Length;
+            char Text[LOG_RECORD_SIZE];
+        };
+
+        //  A bounded queue of records, filled by any thread and drained by one writer thread that
+        //  keeps the log file open. Producers only claim a slot with a compare-and-swap, so none
+        //  of them waits for another or for the file.
+        class Logger {
+            public:
+                Logger() {
+                    for (std::size_t i = 0; i < LOG_CAPACITY; i++) slots[i].Sequence.store(i, std::memory_order_relaxed);
+                    writer = std::thread([this] { run(); });
+                }
+
+                void Push(const std::string& message, const std::string& caller, const std::string& tag) {
+                    std::size_t pos = tail.load(std::memory_order_relaxed);
+                    LogSlot* slot;
+                    for (;;) {
+                        slot = &slots[pos & (LOG_CAPACITY - 1)];
+                        std::size_t sequence = slot->Sequence.load(std::memory_order_acquire);
+                        if (sequence == pos) {
+                            if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                        } else if (sequence < pos) { // the writer has not taken the record a lap ago
+                            dropped.fetch_add(1, std::memory_order_relaxed);
+                            return;
+                        } else {
+                            pos = tail.load(std::memory_order_relaxed);
+                        }
+                    }
+                    slot->Length = format(slot->Text, message, caller, tag);
+                    slot->Sequence.store(pos + 1, std::memory_order_release);
+                    if (idle.load(std::memory_order_relaxed)) wakeup.notify_one();
+                }
+
+                void Flush() {
+                    std::size_t target = tail.load(std::memory_order_acquire);
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wakeup.notify_one();
+                    flushed.wait(lock, [&] { return written >= target || stopping; });
+                }
+
+                long long GetDropped() const {
+                    return dropped.load(std::memory_order_relaxed);
+                }
+
+                //  Writes out what is queued and stops the writer thread. Run at exit; records pushed
+                //  afterwards are not written.
+                void Stop() {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        stopping = true;
+                    }
+                    wakeup.notify_one();
+                    if (writer.joinable()) writer.join();
+                }
+
+            private:
+                LogSlot slots[LOG_CAPACITY];
+                alignas(64) std::atomic<std::size_t> tail{0};
+                alignas(64) std::atomic<long long> dropped{0};
+                //  The position of the next record to write. Only used by the writer thread.
+                std::size_t head = 0;
+                std::thread writer;
+                //  Guards `written` and `stopping`, and lets the writer sleep while the queue is empty.
+                std::mutex mutex;
+                std::condition_variable wakeup;
+                std::condition_variable flushed;
+                std::size_t written = 0;
+                bool stopping = false;
+                std::atomic<bool> idle{false};
+
+                //  Formats a record into `out`, and returns its length.
+                static std::size_t format(char* out, const std::string& message, const std::string& caller, const std::string& tag) {
+                    //  The timestamp only changes once a second, so each thread keeps the last one
+                    thread_local std::time_t stampSecond = -1;
+                    thread_local char stamp[20];
+                    std::time_t now = std::time(nullptr);
+                    if (now != stampSecond) {
+                        std::tm localtm;
+                        localtime_r(&now, &localtm);
+                        std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &localtm);
+                        stampSecond = now;
+                    }
+
+                    std::size_t length = 0;
+                    auto append = [&](const char* text, std::size_t size) {
+                        size = std::min(size, LOG_RECORD_SIZE - 1 - length); // keep room for the line break
+                        std::memcpy(out + length, text, size);
+                        length += size;
+                    };
+                    append(stamp, std::strlen(stamp));
+                    append(" [", 2);
+                    append(tag.data(), tag.size());
+                    append("]", 1);
+                    if (!caller.empty()) {
+                        append(" (", 2);
+                        append(caller.data(), caller.size());
+                        append(")", 1);
+                    }
+                    append(" ", 1);
+                    append(message.data(), message.size());
+                    out[length++] = '\n';
+                    return length;
+                }
+
+                void run() {
+                    std::ofstream logStream;
+                    long long droppedReported = 0;
+                    for (;;) {
+                        if (!logStream.is_open()) logStream.open(LOG_FILE, std::ofstream::app);
+
+                        //  Write out every record that is ready
+                        bool wrote = false;
+                        for (;;) {
+                            LogSlot& slot = slots[head & (LOG_CAPACITY - 1)];
+                            if (slot.Sequence.load(std::memory_order_acquire) != head + 1) break;
+                            if (logStream.is_open()) logStream.write(slot.Text, slot.Length);
+                            slot.Sequence.store(head + LOG_CAPACITY, std::memory_order_release);
+                            head++;
+                            wrote = true;
+                        }
+                        long long droppedNow = dropped.load(std::memory_order_relaxed);
+                        if (droppedNow != droppedReported && logStream.is_open()) {
+                            char text[LOG_RECORD_SIZE];
+                            std::size_t length = format(text, std::to_string(droppedNow - droppedReported)
+                                + " log records dropped, the log queue was full.", "util::WriteToLog()", "WARN");
+                            logStream.write(text, length);
+                            droppedReported = droppedNow;
+                            wrote = true;
+                        }
+                        if (wrote && logStream.is_open()) logStream.flush();
+
+                        std::unique_lock<std::mutex> lock(mutex);
+                        written = head;
+                        flushed.notify_all();
+                        if (stopping && slots[head & (LOG_CAPACITY - 1)].Sequence.load(std::memory_order_acquire) != head + 1) return;
+                        if (wrote) continue;
+                        //  A record pushed while going idle may miss the notification, so never
+                        //  sleep for long
+                        idle.store(true, std::memory_order_relaxed);
+                        wakeup.wait_for(lock, std::chrono::milliseconds(20));
+                        idle.store(false, std::memory_order_relaxed);
+                    }
+                }
+        };
+
+        //  Returns the logger, starting its writer thread on first use. It is never destroyed, so
+        //  threads still running at exit can log; the records queued by then are written out at exit.
+        Logger& logger() {
+            static Logger* instance = [] {
+                auto instance = new Logger();
+                std::atexit([] { logger().Stop(); });
+                return instance;
+            }();
+            return *instance;
         }
 
-        // Get current time
-        std::time_t now = std::time(nullptr);
-        std::tm* localtm = std::localtime(&now);
+    }
+
+    namespace {
+
+        //  The lowest level written to the log.
+        std::atomic<int> logThreshold{static_cast<int>(LogLevel::DEBUG)};
 
-        std::ostringstream oss;
-        oss << std::put_time(localtm, "%Y-%m-%d %H:%M:%S");
-        std::string timeStr = oss.str();
+        const char* const LEVEL_NAMES[] = {"DEBUG", "INFO", "WARN", "ERROR", "FATAL", "OFF"};
 
-        logStream << timeStr << " [" << tag << "]";
-        if (!caller.empty()) {
-            logStream << " (" << caller << ")";
+        LogLevel levelOfTag(const std::string& tag) {
+            if (tag == "WARNING") return LogLevel::WARN;
+            for (int level = 0; level < static_cast<int>(LogLevel::OFF); level++) {
+                if (tag == LEVEL_NAMES[level]) return static_cast<LogLevel>(level);
+            }
+            return LogLevel::INFO;
         }
-        logStream << " " << message << std::endl;
-        logStream.close();
+
+    }
+
+    void WriteToLog(const std::string& message, const std::string& caller, const std::string& tag) {
+        if (!IsLogEnabled(levelOfTag(tag))) return;
+        logger().Push(message, caller, tag);
+    }
+
+    void WriteToLog(LogLevel level, const std::string& message, const std::string& caller) {
+        if (!IsLogEnabled(level)) return;
+        logger().Push(message, caller, GetLogLevelName(level));
+    }
+
+    void SetLogLevel(LogLevel level) {
+        logThreshold.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
+    LogLevel GetLogLevel() {
+        return static_cast<LogLevel>(logThreshold.load(std::memory_order_relaxed));
+    }
+
+    bool IsLogEnabled(LogLevel level) {
+        int value = static_cast<int>(level);
+        return value >= UTIL_LOG_MIN_LEVEL && value < static_cast<int>(LogLevel::OFF)
+            && value >= logThreshold.load(std::memory_order_relaxed);
+    }
+
+    const char* GetLogLevelName(LogLevel level) {
+        return LEVEL_NAMES[static_cast<int>(level)];
+    }
+
+    void FlushLog() {
+        logger().Flush();
+    }
+
+    long long GetDroppedLogRecords() {
+        return logger().GetDropped();
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,64 @@
+#include <util/random.hpp>
+
+namespace util {
+
+    //  Returns x rotated left by k bits.
+    static inline std::uint64_t rotateLeft(std::uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    Random::Random(std::uint64_t seed) {
+        // splitmix64, so that similar seeds still give unrelated states, and the state is never all zero
+        for (auto& word : state) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            std::uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    std::uint64_t Random::Next() {
+        std::uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+        std::uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotateLeft(state[3], 45);
+        return result;
+    }
+
+    int Random::NextInt(int bound) {
+        // Reject the top partial range of 64-bit values so that every result is equally likely
+        std::uint64_t range = static_cast<std::uint64_t>(bound);
+        std::uint64_t limit = UINT64_MAX - UINT64_MAX % range;
+        std::uint64_t value;
+        do {
+            value = Next();
+        } while (value >= limit);
+        return static_cast<int>(value % range);
+    }
+
+    int Random::NextInt(int min, int max) {
+        return min + NextInt(max - min + 1);
+    }
+
+    void Random::Jump() {
+        static const std::uint64_t JUMP[] = {
+            0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+        };
+        std::uint64_t jumped[4] = {0, 0, 0, 0};
+        for (auto word : JUMP) {
+            for (int bit = 0; bit < 64; bit++) {
+                if (word & (1ULL << bit)) {
+                    for (int i = 0; i < 4; i++) jumped[i] ^= state[i];
+                }
+                Next();
+            }
+        }
+        for (int i = 0; i < 4; i++) state[i] = jumped[i];
+    }
+
+}
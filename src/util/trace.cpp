@@ -0,0 +1,137 @@
+#include <util/trace.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace util {
+
+    namespace {
+
+        //  The most spans a thread keeps before WriteTrace(). Later spans are dropped.
+        constexpr std::size_t MAX_SPANS_PER_THREAD = 1 << 20;
+
+        struct TraceEvent {
+            const char* Name;
+            long long StartMicros;
+            long long DurationMicros;
+        };
+
+        //  The spans of one thread. The lock is only contended while the trace is written.
+        struct ThreadTrace {
+            int ThreadId;
+            std::mutex Mutex;
+            std::vector<TraceEvent> Events;
+            //  Whether the thread has exited. Its buffer is then deleted once its spans are written.
+            bool Exited = false;
+        };
+
+        //  The buffers of every thread that recorded a span. Buffers outlive their threads, so
+        //  the spans of worker threads that have exited are still written.
+        struct TraceRegistry {
+            std::mutex Mutex;
+            std::vector<ThreadTrace*> Threads;
+            //  The id given to the last thread. Ids are not reused once a buffer is deleted.
+            int LastThreadId = 0;
+            std::atomic<long long> Dropped{0};
+        };
+
+        TraceRegistry& registry() {
+            static TraceRegistry* instance = new TraceRegistry();
+            return *instance;
+        }
+
+        const std::chrono::steady_clock::time_point EPOCH = std::chrono::steady_clock::now();
+
+        //  Removes the buffer from the registry and deletes it. The registry lock must be held.
+        void releaseTrace(TraceRegistry& traces, ThreadTrace* trace) {
+            traces.Threads.erase(std::find(traces.Threads.begin(), traces.Threads.end(), trace));
+            delete trace;
+        }
+
+        //  Owns the buffer of a thread. When the thread exits, the buffer is deleted if it holds
+        //  no spans, and otherwise left for WriteTrace() to delete once it has written them.
+        struct ThreadTraceOwner {
+            ThreadTrace* Trace = nullptr;
+
+            ~ThreadTraceOwner() {
+                if (Trace == nullptr) return;
+                auto& traces = registry();
+                std::lock_guard<std::mutex> lock(traces.Mutex);
+                bool empty;
+                {
+                    std::lock_guard<std::mutex> threadLock(Trace->Mutex);
+                    empty = Trace->Events.empty();
+                    Trace->Exited = true;
+                }
+                if (empty) releaseTrace(traces, Trace);
+            }
+        };
+
+        ThreadTrace& threadTrace() {
+            thread_local ThreadTraceOwner own;
+            if (own.Trace == nullptr) {
+                auto& traces = registry();
+                std::lock_guard<std::mutex> lock(traces.Mutex);
+                own.Trace = new ThreadTrace();
+                own.Trace->ThreadId = ++traces.LastThreadId;
+                traces.Threads.push_back(own.Trace);
+            }
+            return *own.Trace;
+        }
+
+    }
+
+    void SetTracingEnabled(bool enabled) {
+        TracingEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    long long WriteTrace(const std::string& path) {
+        std::ofstream traceStream(path, std::ofstream::out | std::ofstream::trunc);
+        if (!traceStream.is_open()) return -1;
+
+        auto& traces = registry();
+        std::lock_guard<std::mutex> lock(traces.Mutex);
+        long long written = 0;
+        traceStream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        std::vector<ThreadTrace*> exited;
+        for (auto thread : traces.Threads) {
+            std::vector<TraceEvent> events;
+            {
+                std::lock_guard<std::mutex> threadLock(thread->Mutex);
+                events.swap(thread->Events);
+                if (thread->Exited) exited.push_back(thread);
+            }
+            for (const auto& event : events) {
+                traceStream << (written++ > 0 ? ",\n" : "\n") << "{\"name\":\"" << event.Name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                    << thread->ThreadId << ",\"ts\":" << event.StartMicros << ",\"dur\":" << event.DurationMicros << "}";
+            }
+        }
+        traceStream << "\n]}\n";
+        for (auto thread : exited) releaseTrace(traces, thread);
+        return traceStream.good() ? written : -1;
+    }
+
+    long long GetDroppedTraceSpans() {
+        return registry().Dropped.load(std::memory_order_relaxed);
+    }
+
+    long long TraceSpan::now() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - EPOCH).count();
+    }
+
+    void TraceSpan::record(const char* name, long long startMicros) {
+        long long endMicros = now();
+        auto& trace = threadTrace();
+        std::lock_guard<std::mutex> lock(trace.Mutex);
+        if (trace.Events.size() >= MAX_SPANS_PER_THREAD) {
+            registry().Dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (trace.Events.capacity() == 0) trace.Events.reserve(4096);
+        trace.Events.push_back({name, startMicros, endMicros - startMicros});
+    }
+
+}
@@ -0,0 +1,68 @@
+#include <util/worker_pool.hpp>
+
+namespace util {
+
+    WorkerPool::WorkerPool(int workerCount) : nextJob(0) {
+        if (workerCount <= 0) workerCount = static_cast<int>(std::thread::hardware_concurrency());
+        this->workerCount = workerCount > 0 ? workerCount : 1;
+        for (int i = 1; i < this->workerCount; i++) threads.emplace_back(&WorkerPool::threadLoop, this, i);
+    }
+
+    WorkerPool::~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        batchStarted.notify_all();
+        for (auto& thread : threads) thread.join();
+    }
+
+    int WorkerPool::GetWorkerCount() const {
+        return workerCount;
+    }
+
+    void WorkerPool::Run(int count, const std::function<void(int, int)>& job) {
+        if (count <= 0) return;
+        if (threads.empty() || count == 1) { // not worth waking the threads
+            for (int i = 0; i < count; i++) job(i, 0);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->job = &job;
+            jobCount = count;
+            nextJob = 0;
+            busyThreads = static_cast<int>(threads.size());
+            batch++;
+        }
+        batchStarted.notify_all();
+        runJobs(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        batchDone.wait(lock, [this] { return busyThreads == 0; });
+        this->job = nullptr;
+    }
+
+    void WorkerPool::runJobs(int worker) {
+        for (int i = nextJob.fetch_add(1); i < jobCount; i = nextJob.fetch_add(1)) (*job)(i, worker);
+    }
+
+    void WorkerPool::threadLoop(int worker) {
+        unsigned long long lastBatch = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                batchStarted.wait(lock, [&] { return stopping || batch != lastBatch; });
+                if (stopping) return;
+                lastBatch = batch;
+            }
+            runJobs(worker);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--busyThreads == 0) batchDone.notify_one();
+            }
+        }
+    }
+
+}